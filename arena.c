@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "arena.h"
+
+// Block header, padded so the data after it keeps ARENA_ALIGN
+struct ArenaBlock {
+    ArenaBlock* next;
+    u32 size;  // Usable bytes after the header
+    u32 used;
+    u8 pad[ARENA_ALIGN - sizeof(ArenaBlock*) - 2 * sizeof(u32)];
+};
+
+// Free standard blocks shared by every arena; arenas fill and reset on
+// worker and builder threads, so taking and giving back is locked
+static struct {
+    mutex_t lock;
+    bool started;
+    ArenaBlock* free;
+    ArenaPoolStats stats;
+} arenaPool;
+
+static size_t alignSize(size_t bytes) {
+    return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+void initArenaPool() {
+    if (arenaPool.started) return;
+
+    LWP_MutexInit(&arenaPool.lock, false);
+    arenaPool.free = NULL;
+    memset(&arenaPool.stats, 0, sizeof(arenaPool.stats));
+    arenaPool.started = true;
+}
+
+void shutdownArenaPool() {
+    if (!arenaPool.started) return;
+
+    while (arenaPool.free) {
+        ArenaBlock* block = arenaPool.free;
+        arenaPool.free = block->next;
+        free(block);
+    }
+    arenaPool.stats.freeBlocks = 0;
+    LWP_MutexDestroy(arenaPool.lock);
+    arenaPool.started = false;
+}
+
+void arenaPoolStats(ArenaPoolStats* stats) {
+    if (!arenaPool.started) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    LWP_MutexLock(arenaPool.lock);
+    *stats = arenaPool.stats;
+    LWP_MutexUnlock(arenaPool.lock);
+}
+
+// Standard sizes come from the pool when it has one, anything else straight from the heap
+static ArenaBlock* takeBlock(size_t size) {
+    if (size == ARENA_BLOCK_SIZE && arenaPool.started) {
+        LWP_MutexLock(arenaPool.lock);
+        ArenaBlock* block = arenaPool.free;
+        if (block) {
+            arenaPool.free = block->next;
+            arenaPool.stats.freeBlocks--;
+            arenaPool.stats.blocksReused++;
+        } else {
+            arenaPool.stats.blocksMade++;
+        }
+        LWP_MutexUnlock(arenaPool.lock);
+        if (block) return block;
+    }
+
+    ArenaBlock* block = (ArenaBlock*)memalign(ARENA_ALIGN, sizeof(ArenaBlock) + size);
+    if (block) block->size = (u32)size;
+    return block;
+}
+
+static void giveBlock(ArenaBlock* block) {
+    if (block->size == ARENA_BLOCK_SIZE && arenaPool.started) {
+        LWP_MutexLock(arenaPool.lock);
+        bool keep = arenaPool.stats.freeBlocks < ARENA_POOL_MAX_FREE;
+        if (keep) {
+            block->next = arenaPool.free;
+            arenaPool.free = block;
+            arenaPool.stats.freeBlocks++;
+        }
+        LWP_MutexUnlock(arenaPool.lock);
+        if (keep) return;
+    }
+    free(block);
+}
+
+void arenaInit(Arena* arena) {
+    memset(arena, 0, sizeof(*arena));
+}
+
+// Start a new block that holds at least bytes; big requests get a block of their own size
+static bool pushBlock(Arena* arena, size_t bytes) {
+    size_t size = bytes > ARENA_BLOCK_SIZE ? alignSize(bytes) : ARENA_BLOCK_SIZE;
+    ArenaBlock* block = takeBlock(size);
+    if (!block) return false;
+
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+    arena->blocks++;
+    arena->reserved += block->size;
+    return true;
+}
+
+// Make sure the next bytes worth of allocations land in one block,
+// sized exactly when it's more than a standard block
+bool arenaReserve(Arena* arena, size_t bytes) {
+    bytes = alignSize(bytes);
+    if (arena->head && arena->head->size - arena->head->used >= bytes) return true;
+    return pushBlock(arena, bytes);
+}
+
+void* arenaAlloc(Arena* arena, size_t bytes) {
+    bytes = alignSize(bytes ? bytes : 1);
+    if (!arena->head || arena->head->size - arena->head->used < bytes) {
+        if (bytes > ARENA_BLOCK_SIZE && arena->head) {
+            // Oversized: a block of its own behind the current one, which keeps filling
+            ArenaBlock* block = takeBlock(bytes);
+            if (!block) return NULL;
+            block->used = (u32)bytes;
+            block->next = arena->head->next;
+            arena->head->next = block;
+            arena->blocks++;
+            arena->reserved += block->size;
+            arena->used += bytes;
+            arena->allocations++;
+            return block + 1;
+        }
+        if (!pushBlock(arena, bytes)) return NULL;
+    }
+
+    ArenaBlock* block = arena->head;
+    void* p = (u8*)(block + 1) + block->used;
+    block->used += (u32)bytes;
+    arena->used += bytes;
+    arena->allocations++;
+    return p;
+}
+
+void* arenaCalloc(Arena* arena, size_t bytes) {
+    void* p = arenaAlloc(arena, bytes);
+    if (p) memset(p, 0, bytes);
+    return p;
+}
+
+// Drop everything at once; the cost is per block, not per allocation
+void arenaReset(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        giveBlock(block);
+        block = next;
+    }
+    arenaInit(arena);
+}
+
+void arenaAddStats(const Arena* arena, ArenaStats* stats) {
+    if (!arena->blocks) return;
+    stats->arenas++;
+    stats->blocks += arena->blocks;
+    stats->allocations += arena->allocations;
+    stats->used += arena->used;
+    stats->reserved += arena->reserved;
+}
@@ -0,0 +1,49 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <gccore.h>
+#include <stddef.h>
+
+// Region allocator: allocations are bumped out of blocks and only ever freed
+// all at once. Standard-size blocks go back to a shared pool on reset, so a
+// world that comes and goes reuses the same memory instead of fragmenting the heap
+#define ARENA_BLOCK_SIZE     (4 * 1024)   // Standard block, recycled through the pool
+#define ARENA_ALIGN          32           // Every allocation, so GX can read vertex data directly
+#define ARENA_POOL_MAX_FREE  256          // Standard blocks the pool keeps for reuse
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;  // Block being filled, older ones follow
+    u32 blocks;
+    u32 allocations;
+    size_t used;      // Bytes handed out
+    size_t reserved;  // Bytes held in blocks
+} Arena;
+
+typedef struct {
+    u32 arenas;  // Non-empty arenas counted
+    u32 blocks;
+    u32 allocations;
+    size_t used;
+    size_t reserved;
+} ArenaStats;
+
+typedef struct {
+    u32 freeBlocks;    // Standard blocks waiting in the pool
+    u32 blocksMade;    // Standard blocks ever allocated from the heap
+    u32 blocksReused;  // Standard blocks handed out again from the pool
+} ArenaPoolStats;
+
+void initArenaPool();
+void shutdownArenaPool();
+void arenaPoolStats(ArenaPoolStats* stats);
+
+void arenaInit(Arena* arena);
+bool arenaReserve(Arena* arena, size_t bytes);
+void* arenaAlloc(Arena* arena, size_t bytes);
+void* arenaCalloc(Arena* arena, size_t bytes);
+void arenaReset(Arena* arena);
+void arenaAddStats(const Arena* arena, ArenaStats* stats);
+
+#endif
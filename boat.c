@@ -1,6 +1,7 @@
 #include <gccore.h>
 #include <math.h>
 #include "boat.h"
+#include "water.h"
 
 
 // Initialize boat with default values
@@ -17,8 +18,7 @@ void initBoat(Boat* boat) {
 void updateBoat(Boat* boat, bool upp, bool down, bool left, bool right, float time, IslandManager* islandManager) {
 
     // Compute wave height at boat's current position
-    float boatHeight = sinf((boat->position.x + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE +
-        cosf((boat->position.z + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE;
+    float boatHeight = waveHeightAt(boat->position.x, boat->position.z, time);
 
     // Current position of the boat (for collision and indicator)
     Vec3 curPos = {
@@ -27,38 +27,61 @@ void updateBoat(Boat* boat, bool upp, bool down, bool left, bool right, float ti
         boat->position.z
     };
 
-    // Forward and backward position for collision checking
-    Vec3 backwardPos = {
-        boat->position.x + sinf(boat->yaw) * boat->speed,
-        boatHeight,
-        boat->position.z - cosf(boat->yaw) * boat->speed
-    };
+    // Forward and backward movement for this frame
+    float moveX = -sinf(boat->yaw) * boat->speed;
+    float moveZ = cosf(boat->yaw) * boat->speed;
 
-    Vec3 forwardPos = {
-        boat->position.x - sinf(boat->yaw) * boat->speed,
-        boatHeight,
-        boat->position.z + cosf(boat->yaw) * boat->speed
-    };
+    // Keep the hull this far from the waterline
+    float contactDist = boat->radius * 0.5f;
 
-    // Collision checks
-    bool frontBlocked = checkAllIslandsCollision(islandManager, forwardPos, boat->radius);
-    bool currentlyBlocked = checkAllIslandsCollision(islandManager, curPos, boat->radius);
-    bool behindBlocked = checkAllIslandsCollision(islandManager, backwardPos, boat->radius);
+    // Coast lookups (constant time per island via the shoreline SDF)
+    Vec3 gradient;
+    float curDist = shoreDistance(islandManager, curPos, &gradient);
+    Vec3 forwardPos = { curPos.x + moveX, boatHeight, curPos.z + moveZ };
+    Vec3 backwardPos = { curPos.x - moveX, boatHeight, curPos.z - moveZ };
+    float frontDist = shoreDistance(islandManager, forwardPos, NULL);
+    float behindDist = shoreDistance(islandManager, backwardPos, NULL);
+
+    // Moves that head further out to sea are always allowed, so a boat spawned on land can leave
+    bool frontBlocked = frontDist < contactDist && frontDist < curDist;
+    bool behindBlocked = behindDist < contactDist && behindDist < curDist;
 
     // Show indicator if near island
-    if (frontBlocked || currentlyBlocked || behindBlocked) {
+    if (curDist < boat->radius) {
         drawIndicator(curPos);
     }
 
     // Movement
-    if (down && !behindBlocked) {
-        boat->position.x += sinf(boat->yaw) * boat->speed;
-        boat->position.z -= cosf(boat->yaw) * boat->speed;
+    float dirX = 0.0f, dirZ = 0.0f;
+    bool blocked = false;
+    if (upp) {
+        dirX += moveX;
+        dirZ += moveZ;
+        blocked = frontBlocked;
+    }
+    if (down) {
+        dirX -= moveX;
+        dirZ -= moveZ;
+        blocked = blocked || behindBlocked;
     }
 
-    if (upp && !frontBlocked) {
-        boat->position.x -= sinf(boat->yaw) * boat->speed;
-        boat->position.z += cosf(boat->yaw) * boat->speed;
+    if (!blocked) {
+        boat->position.x += dirX;
+        boat->position.z += dirZ;
+    }
+    else {
+        // Slide along the coast: drop the part of the move that heads into land
+        float intoShore = dirX * gradient.x + dirZ * gradient.z;
+        if (intoShore < 0.0f) {
+            dirX -= intoShore * gradient.x;
+            dirZ -= intoShore * gradient.z;
+        }
+        Vec3 slidePos = { curPos.x + dirX, boatHeight, curPos.z + dirZ };
+        float slideDist = shoreDistance(islandManager, slidePos, NULL);
+        if (slideDist >= contactDist || slideDist > curDist) {
+            boat->position.x += dirX;
+            boat->position.z += dirZ;
+        }
     }
 
     // Rotation
@@ -17,6 +17,8 @@ typedef struct {
     float jumpForce;
 } Body;
 
+#define BODY_BOUNDS_RADIUS 0.6f  // Sphere around the drawn pyramid, for culling
+
 void initBody(Body* body, float x, float y, float z);
 void updateBody(Body* body, IslandManager* manager, Vec3 playerPos); // make it hop
 void drawBody(Body* body);
@@ -1,12 +1,9 @@
 #include "bodyManager.h"
+#include "rng.h"
+#include "profiler.h"
 #include <stdlib.h>
 #include <math.h>
 
-// Helper: Random float in range
-static float randomFloat(float min, float max) {
-    return min + (max - min) * ((float)rand() / RAND_MAX);
-}
-
 void initBodyManager(BodyManager* manager) {
     manager->count = 0;
 }
@@ -17,11 +14,15 @@ void spawnBodiesOnIslands(BodyManager* manager, IslandManager* islands) {
         Island* island = islands->islands[i];
         if (!island) continue;
 
-        int numBodies = rand() % 10 + 1;  // 14 per island
+        // Bodies come from the island's own stream, so they land in the same spots every time
+        Rng rng;
+        rngSeed(&rng, island->seed, RNG_STREAM_BODIES);
+
+        int numBodies = rngRange(&rng, 10) + 1;  // 14 per island
 
         for (int j = 0; j < numBodies && manager->count < MAX_BODIES; j++) {
-            float angle = randomFloat(0, 2 * M_PI);
-            float distance = randomFloat(0.0f, island->radius * 0.45f);  // Keep them within island
+            float angle = rngFloat(&rng, 0, 2 * M_PI);
+            float distance = rngFloat(&rng, 0.0f, island->radius * 0.45f);  // Keep them within island
             float x = island->position.x + cosf(angle) * distance;
             float z = island->position.z + sinf(angle) * distance;
             float y = 20;  // Start at base level
@@ -37,8 +38,40 @@ void updateBodies(BodyManager* manager, IslandManager* islands, Vec3 playerPos)
     }
 }
 
-void drawBodies(BodyManager* manager) {
+// Tested FRUSTUM_BATCH bodies at a time
+void drawBodies(BodyManager* manager, const Frustum* frustum, const OcclusionBuffer* occlusion) {
+    for (int first = 0; first < manager->count; first += FRUSTUM_BATCH) {
+        SphereBatch spheres;
+        spheres.count = 0;
+        for (int i = first; i < manager->count && spheres.count < FRUSTUM_BATCH; i++) {
+            Body* body = &manager->bodies[i];
+            addSphere(&spheres, body->position.x, body->position.y, body->position.z, BODY_BOUNDS_RADIUS);
+        }
+
+        u8 visible[FRUSTUM_BATCH];
+        int count = cullSphereBatch(frustum, &spheres, visible);
+        profileCount(PROF_BODIES_CULLED, spheres.count - count);
+        for (int v = 0; v < count; v++) {
+            Body* body = &manager->bodies[first + visible[v]];
+            if (occlusion) {
+                Vec3 min = { body->position.x - BODY_BOUNDS_RADIUS, body->position.y - BODY_BOUNDS_RADIUS,
+                    body->position.z - BODY_BOUNDS_RADIUS };
+                Vec3 max = { body->position.x + BODY_BOUNDS_RADIUS, body->position.y + BODY_BOUNDS_RADIUS,
+                    body->position.z + BODY_BOUNDS_RADIUS };
+                if (boxOccluded(occlusion, min, max)) {
+                    profileCount(PROF_BODIES_OCCLUDED, 1);
+                    continue;
+                }
+            }
+            drawBody(body);
+        }
+    }
+}
+
+// Floating origin moved
+void shiftBodies(BodyManager* manager, float dx, float dz) {
     for (int i = 0; i < manager->count; i++) {
-        drawBody(&manager->bodies[i]);
+        manager->bodies[i].position.x += dx;
+        manager->bodies[i].position.z += dz;
     }
 }
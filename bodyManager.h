@@ -4,6 +4,7 @@
 #include "body.h"
 #include "common.h"
 #include "manager.h"  // Only used for spawning and collision
+#include "frustum.h"
 #include <stdbool.h>
 
 #define MAX_BODIES 64
@@ -16,6 +17,7 @@ typedef struct {
 void initBodyManager(BodyManager* manager);
 void spawnBodiesOnIslands(BodyManager* manager, IslandManager* islands);
 void updateBodies(BodyManager* manager, IslandManager* islands, Vec3 playerPos);
-void drawBodies(BodyManager* manager);
+void drawBodies(BodyManager* manager, const Frustum* frustum, const OcclusionBuffer* occlusion);
+void shiftBodies(BodyManager* manager, float dx, float dz);
 
 #endif
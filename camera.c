@@ -1,6 +1,7 @@
 // camera.c
 #include "camera.h"
 #include "manager.h"
+#include "profiler.h"
 #include <math.h>
 
 void initCamera(Camera* camera) {
@@ -16,10 +17,12 @@ void initCamera(Camera* camera) {
     camera->followDistance = 5.0f;
     camera->heightOffset = 0.5f;
 
-    camera->zoomLevel = 0.0f;
-    camera->minZoom = -5.0f; // max zoom in
-    camera->maxZoom = 5.0f;  // max zoom out
-    camera->zoomSpeed = 0.02f;
+    camera->armLength = camera->followDistance;
+    camera->minArmLength = 0.5f;
+    camera->armReturnSpeed = 0.1f;
+
+    camera->cacheValid = false;
+    camera->cacheThreshold = 0.05f;
 
     camera->smoothingSpeed = 0.5f;
 }
@@ -28,6 +31,74 @@ static float lerp(float a, float b, float t) {
     return a + (b - a) * t;
 }
 
+static float distanceSq(guVector a, Vec3 b) {
+    float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Cast a small fan of rays from the target toward the desired camera spot and
+// return the longest arm length that keeps every ray clear of the islands
+static float findClearArmLength(Camera* camera, Vec3 pivot, Vec3 desired, IslandManager* manager) {
+    float thresholdSq = camera->cacheThreshold * camera->cacheThreshold;
+    if (camera->cacheValid &&
+        distanceSq(camera->cachedPivot, pivot) < thresholdSq &&
+        distanceSq(camera->cachedDesired, desired) < thresholdSq) {
+        profileCount(PROF_CAMERA_CACHE_HITS, 1);
+        return camera->cachedClearLength;
+    }
+
+    u64 start = profileStart();
+
+    Vec3 arm = { desired.x - pivot.x, desired.y - pivot.y, desired.z - pivot.z };
+
+    // Two axes perpendicular to the arm for spreading the outer rays
+    Vec3 side = { -arm.z, 0.0f, arm.x };
+    float sideLen = sqrtf(side.x * side.x + side.z * side.z);
+    if (sideLen > 0.0f) { side.x /= sideLen; side.z /= sideLen; }
+    Vec3 up = {
+        side.y * arm.z - side.z * arm.y,
+        side.z * arm.x - side.x * arm.z,
+        side.x * arm.y - side.y * arm.x
+    };
+    float upLen = sqrtf(up.x * up.x + up.y * up.y + up.z * up.z);
+    if (upLen > 0.0f) { up.x /= upLen; up.y /= upLen; up.z /= upLen; }
+
+    static const float fanOffsets[CAMERA_FAN_RAYS][2] = {
+        { 0.0f, 0.0f }, { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f }
+    };
+
+    float clearFraction = 1.0f;
+    for (int i = 0; i < CAMERA_FAN_RAYS; i++) {
+        float sx = fanOffsets[i][0] * CAMERA_PROBE_RADIUS;
+        float uy = fanOffsets[i][1] * CAMERA_PROBE_RADIUS;
+        Vec3 dir = {
+            arm.x + side.x * sx + up.x * uy,
+            arm.y + side.y * sx + up.y * uy,
+            arm.z + side.z * sx + up.z * uy
+        };
+        float len = sqrtf(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+        if (len <= 0.0f) continue;
+        dir.x /= len; dir.y /= len; dir.z /= len;
+
+        float hit = raycastIslands(manager, pivot, dir, len);
+        if (hit / len < clearFraction) clearFraction = hit / len;
+    }
+    profileCount(PROF_CAMERA_RAYS, CAMERA_FAN_RAYS);
+
+    // Back off by the probe radius so the near plane stays out of the hit surface
+    float clearLength = clearFraction * camera->followDistance;
+    if (clearFraction < 1.0f) clearLength -= CAMERA_PROBE_RADIUS;
+    if (clearLength < camera->minArmLength) clearLength = camera->minArmLength;
+    if (clearLength > camera->followDistance) clearLength = camera->followDistance;
+
+    camera->cachedPivot = (guVector){ pivot.x, pivot.y, pivot.z };
+    camera->cachedDesired = (guVector){ desired.x, desired.y, desired.z };
+    camera->cachedClearLength = clearLength;
+    camera->cacheValid = true;
+
+    profileStop(PROF_CAMERA_OCCLUSION, start);
+    return clearLength;
+}
 
 void updateCamera(Camera* camera, const Boat* boat, const Player* player, bool isPlayerActive, IslandManager* manager) {
     const guVector* pos;
@@ -42,45 +113,35 @@ void updateCamera(Camera* camera, const Boat* boat, const Player* player, bool i
         yaw = boat->yaw;
     }
 
-    // Convert guVector to Vec3 for compatibility
-    Vec3 camPos = { camera->position.x, camera->position.y, camera->position.z };
-    Vec3 playerPos = { pos->x, pos->y, pos->z };
+    // Full-length arm direction behind the target
+    Vec3 pivot = { pos->x, pos->y, pos->z };
+    Vec3 desired = {
+        pos->x + sinf(yaw) * camera->followDistance,
+        pos->y + camera->heightOffset,
+        pos->z - cosf(yaw) * camera->followDistance
+    };
 
+    float clearLength = findClearArmLength(camera, pivot, desired, manager);
 
-    // move until false or equal to player???
-    if (checkCameraPlayerCovered(camPos, playerPos, manager)) {
-        
-        if (camera->zoomLevel <= camera->minZoom) {
-            camera->zoomLevel = camera->minZoom;
-        } else {
-            camera->zoomLevel -= camera->zoomSpeed;
-        }
+    // Pull in immediately so terrain never sits between camera and target, ease back out
+    bool pulledIn = clearLength < camera->armLength;
+    if (pulledIn) {
+        camera->armLength = clearLength;
     }
     else {
-        if (camera->zoomLevel < 0.0f) {
-            camera->zoomLevel += camera->zoomSpeed;
-            if (camera->zoomLevel > 0.0f)
-                camera->zoomLevel = 0.0f;
-        }
-        else if (camera->zoomLevel > 0.0f) {
-            camera->zoomLevel -= camera->zoomSpeed;
-            if (camera->zoomLevel < 0.0f)
-                camera->zoomLevel = 0.0f;
-        }
+        camera->armLength = lerp(camera->armLength, clearLength, camera->armReturnSpeed);
     }
 
-    float adjustedDistance = camera->followDistance + camera->zoomLevel;
-    float zoomYOffset = -camera->zoomLevel * 0.6f;
-
-    // Target camera position
-    float targetX = pos->x + sinf(yaw) * adjustedDistance;
-    float targetY = pos->y + camera->heightOffset + zoomYOffset;
-    float targetZ = pos->z - cosf(yaw) * adjustedDistance;
+    float armScale = camera->armLength / camera->followDistance;
+    float targetX = pivot.x + (desired.x - pivot.x) * armScale;
+    float targetY = pivot.y + (desired.y - pivot.y) * armScale;
+    float targetZ = pivot.z + (desired.z - pivot.z) * armScale;
 
-    // Smooth interpolation toward target
-    camera->position.x = lerp(camera->position.x, targetX, camera->smoothingSpeed);
-    camera->position.y = lerp(camera->position.y, targetY, camera->smoothingSpeed);
-    camera->position.z = lerp(camera->position.z, targetZ, camera->smoothingSpeed);
+    // Smooth interpolation toward target (skipped when the arm had to pull in)
+    float smoothing = pulledIn ? 1.0f : camera->smoothingSpeed;
+    camera->position.x = lerp(camera->position.x, targetX, smoothing);
+    camera->position.y = lerp(camera->position.y, targetY, smoothing);
+    camera->position.z = lerp(camera->position.z, targetZ, smoothing);
 
     // Look-at point (no need to lerp unless you want a "lazy" camera)
     camera->look.x = pos->x;
@@ -88,3 +149,15 @@ void updateCamera(Camera* camera, const Boat* boat, const Player* player, bool i
     camera->look.z = pos->z;
 
 }
+
+// Floating origin moved; the occlusion cache moves along so it stays valid
+void shiftCamera(Camera* camera, float dx, float dz) {
+    camera->position.x += dx;
+    camera->position.z += dz;
+    camera->look.x += dx;
+    camera->look.z += dz;
+    camera->cachedPivot.x += dx;
+    camera->cachedPivot.z += dz;
+    camera->cachedDesired.x += dx;
+    camera->cachedDesired.z += dz;
+}
@@ -7,6 +7,9 @@
 #include "boat.h"
 #include "player.h"
 
+#define CAMERA_FAN_RAYS      5      // Center ray plus four around the camera end
+#define CAMERA_PROBE_RADIUS  0.3f   // Spread of the outer rays, keeps the near plane out of terrain
+
 typedef struct {
     guVector position;
     guVector up;
@@ -14,10 +17,17 @@ typedef struct {
     float followDistance;
     float heightOffset;
 
-    float zoomLevel;     // Additional zoom modifier
-    float minZoom;
-    float maxZoom;
-    float zoomSpeed;
+    // Spring arm: how far the camera currently sits from the target
+    float armLength;
+    float minArmLength;
+    float armReturnSpeed;  // How fast the arm extends again once the view is clear
+
+    // Cached occlusion result, reused while pivot and camera stay put
+    guVector cachedPivot;
+    guVector cachedDesired;
+    float cachedClearLength;
+    bool cacheValid;
+    float cacheThreshold;
 
     float smoothingSpeed;  // Smoothing factor (e.g., 0.1f)
 } Camera;
@@ -25,5 +35,6 @@ typedef struct {
 
 void initCamera(Camera* camera);
 void updateCamera(Camera* camera, const Boat* boat, const Player* player, bool isPlayerActive, IslandManager* manager);
+void shiftCamera(Camera* camera, float dx, float dz);
 
 #endif // CAMERA_H
@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <math.h>
+#include "chunks.h"
+#include "rng.h"
+#include "placement.h"
+#include "islandCache.h"
+#include "islandLibrary.h"
+
+void defaultChunkSettings(ChunkSettings* settings) {
+    settings->islandSegments = NUM_SEGMENTS;
+    settings->heightmapResolution = ISLAND_HEIGHTMAP_RES;
+    settings->noiseIslandPercent = ISLAND_NOISE_PERCENT;
+    settings->instancedIslandPercent = ISLAND_INSTANCED_PERCENT;
+    settings->islandsPerChunk = ISLANDS_PER_CHUNK;
+    settings->chunkSize = CHUNK_SIZE;
+}
+
+int chunkCoord(const ChunkSettings* settings, float v) {
+    return (int)floorf(v / settings->chunkSize);
+}
+
+// Center of the chunk relative to its origin chunk
+// Only the chunk difference goes through float, so this stays exact far out
+void chunkCenter(const IslandChunk* chunk, const ChunkSettings* settings, float* x, float* z) {
+    *x = (chunk->cx - chunk->originCx + 0.5f) * settings->chunkSize;
+    *z = (chunk->cz - chunk->originCz + 0.5f) * settings->chunkSize;
+}
+
+// Islands of a chunk depend only on the world seed and the chunk coordinate
+static bool generateChunkIslands(IslandChunk* chunk, const ChunkSettings* settings) {
+    int target = settings->islandsPerChunk;
+    if (target <= 0) return true;
+
+    u64 chunkSeed = rngChunkSeed(chunk->worldSeed, chunk->cx, chunk->cz);
+
+    Island** islands = (Island**)arenaCalloc(&chunk->arena, target * sizeof(Island*));
+    float* radii = (float*)malloc(target * sizeof(float));
+    float* posX = (float*)malloc(target * sizeof(float));
+    float* posZ = (float*)malloc(target * sizeof(float));
+
+    // Shapes first, placement needs every island's real radius
+    int generated = 0;
+    if (islands && radii && posX && posZ) {
+        for (; generated < target; generated++) {
+            Island* island = (Island*)arenaCalloc(&chunk->arena, sizeof(Island));
+            if (!island) break;
+
+            island->seed = rngDeriveSeed(chunkSeed, (u32)generated);
+
+            // Which generator is its own stream, the shapes themselves don't shift
+            Rng generatorRng;
+            rngSeed(&generatorRng, island->seed, RNG_STREAM_GENERATOR);
+            if (rngRange(&generatorRng, 100) < settings->noiseIslandPercent) {
+                island->shape = ISLAND_SHAPE_NOISE;
+                island->segments = settings->heightmapResolution;
+            } else {
+                island->shape = ISLAND_SHAPE_POLAR;
+                island->segments = settings->islandSegments;
+            }
+
+            // Instances only need their archetype (islands keep their own shape if the library is missing it)
+            if (rngRange(&generatorRng, 100) < settings->instancedIslandPercent) {
+                island->archetypeIndex = rngRange(&generatorRng, ISLAND_LIBRARY_SIZE);
+                island->archetype = islandArchetype(island->archetypeIndex);
+            }
+            generateIslandParams(island);
+            island->position.y = -2.0f;
+
+            islands[generated] = island;
+            radii[generated] = island->radius;
+        }
+    }
+
+    // Half a gap of margin on each side keeps islands of neighbouring chunks apart too
+    Rng placementRng;
+    rngSeed(&placementRng, chunkSeed, RNG_STREAM_PLACEMENT);
+    float extent = settings->chunkSize * 0.5f - ISLAND_MIN_GAP * 0.5f;
+    int placed = placeDiscs(radii, generated, extent, ISLAND_MIN_GAP, &placementRng, posX, posZ);
+
+    float centerX, centerZ;
+    chunkCenter(chunk, settings, &centerX, &centerZ);
+    for (int i = 0; i < placed; i++) {
+        islands[i]->position.x = centerX + posX[i];
+        islands[i]->position.z = centerZ + posZ[i];
+        finishIslandParams(islands[i]);
+    }
+
+    // Islands that didn't fit are dropped rather than stacked on top of others
+    // (their structs stay in the arena until the chunk goes)
+    free(radii);
+    free(posX);
+    free(posZ);
+
+    chunk->islands = islands;
+    chunk->count = placed;
+    return islands != NULL;
+}
+
+// Chunk from the island cache if it's there, generated otherwise
+// Safe to call from any thread, the chunk isn't shared until it's handed to a manager
+IslandChunk* loadIslandChunk(u64 worldSeed, const ChunkSettings* settings, int cx, int cz, int originCx, int originCz) {
+    IslandChunk* chunk = (IslandChunk*)calloc(1, sizeof(IslandChunk));
+    if (!chunk) return NULL;
+
+    chunk->cx = cx;
+    chunk->cz = cz;
+    chunk->originCx = originCx;
+    chunk->originCz = originCz;
+    chunk->worldSeed = worldSeed;
+
+    if (loadIslandCache(chunk, settings)) {
+        chunk->fromCache = true;
+        return chunk;
+    }
+
+    if (!generateChunkIslands(chunk, settings)) {
+        freeIslandChunk(chunk);
+        return NULL;
+    }
+    return chunk;
+}
+
+// Re-express the chunk's islands relative to another origin chunk
+// Only positions and bounds move, built meshes and collision stay as they are
+void rebaseIslandChunk(IslandChunk* chunk, const ChunkSettings* settings, int originCx, int originCz) {
+    if (chunk->originCx == originCx && chunk->originCz == originCz) return;
+
+    float dx = (chunk->originCx - originCx) * settings->chunkSize;
+    float dz = (chunk->originCz - originCz) * settings->chunkSize;
+    for (int i = 0; i < chunk->count; i++) {
+        shiftIsland(chunk->islands[i], dx, dz);
+    }
+    chunk->originCx = originCx;
+    chunk->originCz = originCz;
+}
+
+// Memory the chunk holds right now, built island stages included
+size_t islandChunkBytes(const IslandChunk* chunk) {
+    size_t bytes = sizeof(IslandChunk) + chunk->arena.reserved;
+    for (int i = 0; i < chunk->count; i++) {
+        bytes += islandHeavyBytes(chunk->islands[i]);
+    }
+    return bytes;
+}
+
+void freeIslandChunk(IslandChunk* chunk) {
+    if (!chunk) return;
+
+    // Per island only the stage regions, everything else goes with the chunk arena
+    for (int i = 0; i < chunk->count; i++) {
+        freeIslandResources(chunk->islands[i]);
+    }
+    arenaReset(&chunk->arena);
+    free(chunk);
+}
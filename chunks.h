@@ -0,0 +1,37 @@
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include "island.h"
+
+// Generation settings shared by every chunk of a world
+typedef struct {
+    int islandSegments;   // Tessellation given to new polar islands
+    int heightmapResolution;  // Heightmap samples per side of new noise islands
+    int noiseIslandPercent;   // Chance an island comes from the noise generator
+    int instancedIslandPercent;  // Chance an island reuses a library archetype instead
+    int islandsPerChunk;  // How many islands placement tries to fit
+    float chunkSize;      // Side length of a chunk in world units
+} ChunkSettings;
+
+// One square of ocean and the islands generated for it
+// Island positions are relative to the origin chunk (originCx, originCz)
+typedef struct {
+    int cx, cz;
+    int originCx, originCz;
+    u64 worldSeed;
+    Island** islands;
+    int count;
+    Arena arena;  // Chunk lifetime data: island structs, the list, the cache file buffer
+    bool fromCache;
+    unsigned int lastUsedFrame;
+} IslandChunk;
+
+void defaultChunkSettings(ChunkSettings* settings);
+int chunkCoord(const ChunkSettings* settings, float v);
+void chunkCenter(const IslandChunk* chunk, const ChunkSettings* settings, float* x, float* z);
+IslandChunk* loadIslandChunk(u64 worldSeed, const ChunkSettings* settings, int cx, int cz, int originCx, int originCz);
+void rebaseIslandChunk(IslandChunk* chunk, const ChunkSettings* settings, int originCx, int originCz);
+size_t islandChunkBytes(const IslandChunk* chunk);
+void freeIslandChunk(IslandChunk* chunk);
+
+#endif
@@ -4,7 +4,6 @@
 #include <gccore.h>
  
 #define DEFAULT_FIFO_SIZE    (256*1024)
-#define WATER_SIZE           100
 #define WAVE_SPEED           0.2f
 #define WAVE_FREQUENCY       0.3f
 #define WAVE_AMPLITUDE       0.25f
@@ -15,13 +14,18 @@
 #define ISLAND_MAX_HEIGHT    10.0f
 #define ISLAND_FLATTENING    0.3f
 
-#define numIslands           1
+#define ISLAND_MIN_GAP       8.0f    // Open water kept between neighbouring shorelines
+
+// The ocean is endless and split into square chunks, each with its own islands
+#define CHUNK_SIZE           256.0f
+#define ISLANDS_PER_CHUNK    3       // Placement target, fewer when they don't fit
 
 #define JOYSTICK_DEADZONE    40
 #define MAX_JOYSTICK_VALUE   70
 
 // The bottom of the world islands
 #define BASE_Y       -0.5f
+#define SEA_LEVEL     0.0f
 #define boatChangeY   0.5f
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <math.h>
+#include "frustum.h"
+
+// Planes straight from the rows of projection * view (Gribb and Hartmann).
+// GX clip space keeps -w <= x, y <= w like GL, but -w <= z <= 0 for depth
+void frustumFromCamera(Frustum* frustum, Mtx44 projection, Mtx view) {
+    float clip[4][4];
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            clip[r][c] = projection[r][0] * view[0][c] + projection[r][1] * view[1][c] +
+                projection[r][2] * view[2][c] + (c == 3 ? projection[r][3] : 0.0f);
+        }
+    }
+
+    // Left, right, bottom, top, near, far
+    static const float xSign[FRUSTUM_PLANES] = { 1, -1, 0, 0, 0, 0 };
+    static const float ySign[FRUSTUM_PLANES] = { 0, 0, 1, -1, 0, 0 };
+    static const float zSign[FRUSTUM_PLANES] = { 0, 0, 0, 0, 1, -1 };
+    static const float wSign[FRUSTUM_PLANES] = { 1, 1, 1, 1, 1, 0 };
+
+    for (int p = 0; p < FRUSTUM_PLANES; p++) {
+        float plane[4];
+        for (int c = 0; c < 4; c++) {
+            plane[c] = wSign[p] * clip[3][c] + xSign[p] * clip[0][c] + ySign[p] * clip[1][c] + zSign[p] * clip[2][c];
+        }
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        frustum->nx[p] = plane[0] * scale;
+        frustum->ny[p] = plane[1] * scale;
+        frustum->nz[p] = plane[2] * scale;
+        frustum->d[p] = plane[3] * scale;
+    }
+}
+
+bool addSphere(SphereBatch* batch, float x, float y, float z, float radius) {
+    if (batch->count >= FRUSTUM_BATCH) return false;
+    int i = batch->count++;
+    batch->x[i] = x;
+    batch->y[i] = y;
+    batch->z[i] = z;
+    batch->radius[i] = radius;
+    return true;
+}
+
+// One plane at a time over the spheres still in, so each pass is a tight loop with the
+// plane in registers. Survivors are compacted without a branch: the index is always
+// written and the count only moves on when the sphere is in front of the plane
+int cullSphereBatch(const Frustum* frustum, const SphereBatch* batch, u8* visible) {
+    int count = batch->count;
+    for (int i = 0; i < count; i++) visible[i] = (u8)i;
+
+    for (int p = 0; p < FRUSTUM_PLANES && count > 0; p++) {
+        float nx = frustum->nx[p], ny = frustum->ny[p], nz = frustum->nz[p], d = frustum->d[p];
+        int kept = 0;
+        for (int k = 0; k < count; k++) {
+            int i = visible[k];
+            float distance = nx * batch->x[i] + ny * batch->y[i] + nz * batch->z[i] + d;
+            visible[kept] = (u8)i;
+            kept += distance >= -batch->radius[i];
+        }
+        count = kept;
+    }
+    return count;
+}
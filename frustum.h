@@ -0,0 +1,34 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <gccore.h>
+
+// View frustum culling against the camera's view and projection matrices
+#define FRUSTUM_PLANES  6
+#define FRUSTUM_BATCH   64  // Spheres per test, small enough for stack buffers
+
+// Planes as structure of arrays, normals point inwards and are unit length
+typedef struct {
+    float nx[FRUSTUM_PLANES], ny[FRUSTUM_PLANES], nz[FRUSTUM_PLANES];
+    float d[FRUSTUM_PLANES];
+} Frustum;
+
+// Bounding spheres gathered for one test, also structure of arrays
+typedef struct {
+    float x[FRUSTUM_BATCH], y[FRUSTUM_BATCH], z[FRUSTUM_BATCH];
+    float radius[FRUSTUM_BATCH];
+    int count;
+} SphereBatch;
+
+// Frame setup, with the same matrices that are loaded for GX; the planes end up in the
+// space of whatever model transform is part of view
+void frustumFromCamera(Frustum* frustum, Mtx44 projection, Mtx view);
+
+// Adds a sphere, returns false once the batch is full
+bool addSphere(SphereBatch* batch, float x, float y, float z, float radius);
+
+// Writes the batch indices of the spheres that touch the frustum to visible, in order,
+// and returns how many there are
+int cullSphereBatch(const Frustum* frustum, const SphereBatch* batch, u8* visible);
+
+#endif
@@ -1,20 +1,18 @@
 #include <gccore.h>
 #include <math.h>
 #include <stdlib.h>
-#include <time.h>
 #include <stdbool.h>
 #include <malloc.h>
+#include <string.h>
 #include "common.h"
 #include "kd_tree.h"
 #include "island.h"
+#include "rng.h"
+#include "noise.h"
+#include "profiler.h"
 #include <stdint.h>
 #include <float.h>
 
-typedef struct {
-    Vec3 position;
-    float r, g, b;
-} IslandVertex;
-
 // Helper function to wrap around control point indices
 static int clampCtrlIndex(int i) {
     int n = NUM_CTRL_POINTS;
@@ -35,11 +33,6 @@ static float catmullRom(float p0, float p1, float p2, float p3, float t) {
         );
 }
 
-// Generate random float between min and max
-static float randomFloat(float min, float max) {
-    return min + (max - min) * ((float)rand() / RAND_MAX);
-}
-
 // New helper functions for more varied island shapes
 static float noise1D(float x, float freq, int octaves) {
     float value = 0.0f;
@@ -61,23 +54,23 @@ static float ridgeNoise(float x, float freq, int octaves) {
     return 1.0f - 2.0f * fabsf(val);
 }
 
-static float randomPeakHeight(Island* island) {
+static float randomPeakHeight(Island* island, Rng* rng) {
     // Base height with random variation
-    float baseHeight = randomFloat(ISLAND_MIN_HEIGHT, ISLAND_MAX_HEIGHT);
+    float baseHeight = rngFloat(rng, ISLAND_MIN_HEIGHT, ISLAND_MAX_HEIGHT);
 
     // Add extra height variation (30% chance of being taller)
-    if (rand() % 100 < 30) {
-        baseHeight *= 1.5f + 0.5f * ((float)rand() / RAND_MAX);
+    if (rngRange(rng, 100) < 30) {
+        baseHeight *= rngFloat(rng, 1.5f, 2.0f);
     }
 
     return baseHeight;
 }
 
 // Simplified island shape generation
-static void generateIslandShape(Island* island, float baseRadius) {
+static void generateIslandShape(Island* island, Rng* rng) {
     // Determine island type (0 = normal, 1 = peaked, 2 = flat, 3 = crater)
-    int islandType = rand() % 4;
-    float peakAngle = 2.0f * M_PI * ((float)rand() / RAND_MAX); // Random peak position
+    int islandType = rngRange(rng, 4);
+    float peakAngle = rngFloat(rng, 0.0f, 2.0f * M_PI); // Random peak position
 
     // Generate control points with more variation
     for (int i = 0; i < NUM_CTRL_POINTS; ++i) {
@@ -87,31 +80,31 @@ static void generateIslandShape(Island* island, float baseRadius) {
 
         // Base radius with more variation
         float radiusVariation = 0.5f + 0.5f * ridgeNoise(angle, 2.0f, 3);
-        island->ctrlRadius[i] = randomFloat(ISLAND_MIN_RADIUS, ISLAND_MAX_RADIUS) * radiusVariation;
+        island->ctrlRadius[i] = rngFloat(rng, ISLAND_MIN_RADIUS, ISLAND_MAX_RADIUS) * radiusVariation;
 
         // Height generation based on island type
         switch (islandType) {
         case 0: // Normal island
-            island->ctrlHeight[i] = randomPeakHeight(island) *
+            island->ctrlHeight[i] = randomPeakHeight(island, rng) *
                 (0.7f + 0.3f * cosf(distanceToPeak * 2.0f));
             break;
         case 1: // Peaked island
-            island->ctrlHeight[i] = randomPeakHeight(island) *
+            island->ctrlHeight[i] = randomPeakHeight(island, rng) *
                 (0.3f + 0.7f * (1.0f - distanceToPeak / M_PI));
             break;
         case 2: // Flat-topped island
-            island->ctrlHeight[i] = randomPeakHeight(island) *
+            island->ctrlHeight[i] = randomPeakHeight(island, rng) *
                 (0.8f - 0.2f * distanceToPeak / M_PI);
             if (distanceToPeak < 0.3f) island->ctrlHeight[i] *= 1.1f;
             break;
         case 3: // Crater island
-            island->ctrlHeight[i] = randomPeakHeight(island) *
+            island->ctrlHeight[i] = randomPeakHeight(island, rng) *
                 (0.5f + 0.5f * sinf(distanceToPeak * 3.0f));
             break;
         }
 
         // Add some noise to break up patterns
-        island->ctrlHeight[i] *= 0.9f + 0.2f * ((float)rand() / RAND_MAX);
+        island->ctrlHeight[i] *= rngFloat(rng, 0.9f, 1.1f);
     }
 
     // Smooth the control points (less smoothing for more variation)
@@ -123,6 +116,34 @@ static void generateIslandShape(Island* island, float baseRadius) {
     }
 }
 
+// Heightmap island: a square of domain-warped fractal noise pushed under water
+// towards its edges, so the coast ends up somewhere inside the square
+static void generateNoiseShape(Island* island, Rng* rng) {
+    island->noiseExtent = rngFloat(rng, ISLAND_MIN_RADIUS, ISLAND_MAX_RADIUS) * (float)M_SQRT1_2;
+    island->noiseHeight = randomPeakHeight(island, rng) * 1.5f;
+
+    island->noise.seed = rngNext(rng);
+    island->noise.frequency = rngFloat(rng, 1.5f, 3.0f) / (2.0f * island->noiseExtent);
+    island->noise.octaves = 5;
+    island->noise.lacunarity = 2.0f;
+    island->noise.gain = 0.5f;
+    island->noise.warp = island->noiseExtent * rngFloat(rng, 0.15f, 0.35f);
+}
+
+// Surface height at island-relative (x[i], z[i]), count points at a time
+static void sampleNoiseHeights(const Island* island, const float* x, const float* z, float* out, int count) {
+    noiseFbmBatch(&island->noise, x, z, out, count);
+
+    // Elevation falls off with distance from the center and is clamped to the seabed
+    float invExtentSq = 1.0f / (island->noiseExtent * island->noiseExtent);
+    for (int i = 0; i < count; i++) {
+        float d2 = (x[i] * x[i] + z[i] * z[i]) * invExtentSq;
+        float e = 0.45f + 0.75f * out[i] - 0.9f * d2;
+        e = fminf(fmaxf(e, 0.0f), 1.0f);
+        out[i] = island->position.y + e * island->noiseHeight;
+    }
+}
+
 // Get interpolated radius at angle theta
 static float getInterpolatedRadius(Island* island, float theta) {
     float t = theta / (2.0f * M_PI) * NUM_CTRL_POINTS;
@@ -153,6 +174,260 @@ static float getInterpolatedHeight(Island* island, float theta) {
         island->ctrlHeight[i2], island->ctrlHeight[i3], localT);
 }
 
+// Radius where the island surface crosses sea level at angle theta
+// Surface height is position.y + (1 - cos^2(phi)) * H, so solve for cos(phi)
+static float waterlineRadius(Island* island, float theta) {
+    float depth = SEA_LEVEL - island->position.y;
+    float h = getInterpolatedHeight(island, theta);
+    if (h <= depth) return 0.0f;  // This side never breaks the surface
+    return getInterpolatedRadius(island, theta) * sqrtf(1.0f - depth / h);
+}
+
+// Distance from (px, pz) to the segment a-b in the XZ plane
+static float segmentDistance2D(float px, float pz, float ax, float az, float bx, float bz) {
+    float abx = bx - ax, abz = bz - az;
+    float apx = px - ax, apz = pz - az;
+    float lenSq = abx * abx + abz * abz;
+    float t = lenSq > 0.0f ? (apx * abx + apz * abz) / lenSq : 0.0f;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    float dx = apx - abx * t, dz = apz - abz * t;
+    return sqrtf(dx * dx + dz * dz);
+}
+
+// Sample the waterline as a closed polygon around the island center and size
+// the SDF grid to cover it (cheap, so it also runs for islands never baked)
+static void layoutShoreSdf(Island* island, float* polyX, float* polyZ) {
+    float maxRadius = 0.0f;
+
+    for (int i = 0; i < SHORE_SAMPLES; ++i) {
+        float theta = (i * 2 * M_PI) / SHORE_SAMPLES;
+        float r = waterlineRadius(island, theta);
+        polyX[i] = r * cosf(theta);
+        polyZ[i] = r * sinf(theta);
+        if (r > maxRadius) maxRadius = r;
+    }
+
+    float halfExtent = maxRadius + SHORE_SDF_MARGIN;
+    island->sdfCellSize = (2.0f * halfExtent) / (SHORE_SDF_RES - 1);
+    island->sdfMinX = island->position.x - halfExtent;
+    island->sdfMinZ = island->position.z - halfExtent;
+}
+
+// The heightmap coast stays inside its square, the SDF grid covers it plus the margin
+static void layoutHeightmapSdf(Island* island) {
+    float halfExtent = island->noiseExtent + SHORE_SDF_MARGIN;
+    island->sdfCellSize = (2.0f * halfExtent) / (SHORE_SDF_RES - 1);
+    island->sdfMinX = island->position.x - halfExtent;
+    island->sdfMinZ = island->position.z - halfExtent;
+}
+
+// Crossing of the sea level on the edge between two samples of height above it
+static void edgeCrossing(float ax, float az, float va, float bx, float bz, float vb, float* x, float* z) {
+    float t = va / (va - vb);
+    *x = ax + (bx - ax) * t;
+    *z = az + (bz - az) * t;
+}
+
+// Keeps segment k as a sample's nearest when it is closer than the one it has
+static void trySegment(const float* segments, int k, float px, float pz, int* nearest, float* distance) {
+    const float* s = &segments[k * 4];
+    float d = segmentDistance2D(px, pz, s[0], s[1], s[2], s[3]);
+    if (d < *distance) {
+        *distance = d;
+        *nearest = k;
+    }
+}
+
+// SDF of a heightmap island: the heights are sampled on the SDF grid itself,
+// the waterline is traced cell by cell (marching squares) into segments and
+// every sample takes its distance to the nearest one
+static void bakeHeightmapSdf(Island* island) {
+    layoutHeightmapSdf(island);
+    island->shoreSdf = (float*)arenaAlloc(&island->collisionArena, SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float));
+    float* above = (float*)malloc(SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float));
+    const int cells = SHORE_SDF_RES - 1;
+    float* segments = (float*)malloc(cells * cells * 2 * 4 * sizeof(float));
+    int* cellStart = (int*)malloc((cells * cells + 1) * sizeof(int));  // Segments of cell c: [cellStart[c], cellStart[c + 1])
+    int* nearest = (int*)malloc(SHORE_SDF_RES * SHORE_SDF_RES * sizeof(int));
+    if (!island->shoreSdf || !above || !segments || !cellStart || !nearest) {
+        free(above);
+        free(segments);
+        free(cellStart);
+        free(nearest);
+        island->shoreSdf = NULL;
+        return;
+    }
+
+    float originX = island->sdfMinX - island->position.x;
+    float originZ = island->sdfMinZ - island->position.z;
+    float cell = island->sdfCellSize;
+
+    float rowX[SHORE_SDF_RES], rowZ[SHORE_SDF_RES];
+    for (int j = 0; j < SHORE_SDF_RES; ++j) {
+        for (int i = 0; i < SHORE_SDF_RES; ++i) {
+            rowX[i] = originX + i * cell;
+            rowZ[i] = originZ + j * cell;
+        }
+        float* row = &above[j * SHORE_SDF_RES];
+        sampleNoiseHeights(island, rowX, rowZ, row, SHORE_SDF_RES);
+        for (int i = 0; i < SHORE_SDF_RES; ++i) row[i] -= SEA_LEVEL;
+    }
+
+    int segmentCount = 0;
+    for (int j = 0; j < cells; ++j) {
+        for (int i = 0; i < cells; ++i) {
+            cellStart[j * cells + i] = segmentCount;
+
+            // Corners counter-clockwise, so crossings come out in pairs along the walk
+            float cx[4] = { originX + i * cell, originX + (i + 1) * cell, originX + (i + 1) * cell, originX + i * cell };
+            float cz[4] = { originZ + j * cell, originZ + j * cell, originZ + (j + 1) * cell, originZ + (j + 1) * cell };
+            float v[4] = {
+                above[j * SHORE_SDF_RES + i], above[j * SHORE_SDF_RES + i + 1],
+                above[(j + 1) * SHORE_SDF_RES + i + 1], above[(j + 1) * SHORE_SDF_RES + i]
+            };
+
+            float px[4], pz[4];
+            int crossings = 0;
+            for (int k = 0; k < 4; ++k) {
+                int n = (k + 1) & 3;
+                if ((v[k] > 0.0f) != (v[n] > 0.0f)) {
+                    edgeCrossing(cx[k], cz[k], v[k], cx[n], cz[n], v[n], &px[crossings], &pz[crossings]);
+                    crossings++;
+                }
+            }
+            for (int k = 0; k + 1 < crossings; k += 2) {
+                float* s = &segments[segmentCount++ * 4];
+                s[0] = px[k];
+                s[1] = pz[k];
+                s[2] = px[k + 1];
+                s[3] = pz[k + 1];
+            }
+        }
+    }
+    cellStart[cells * cells] = segmentCount;
+
+    // Nearest segment per sample: first from the (up to) four cells around it, then handed
+    // on through a forward and a backward sweep, each sample trying its neighbours' nearest.
+    // Two sweeps instead of every sample against every segment, but like any propagated
+    // distance transform it can miss the true nearest by a little, so samples near the
+    // coast (where collision reads the field) are then made exact, see below
+    float* distance = island->shoreSdf;
+    for (int j = 0; j < SHORE_SDF_RES; ++j) {
+        for (int i = 0; i < SHORE_SDF_RES; ++i) {
+            int n = j * SHORE_SDF_RES + i;
+            nearest[n] = -1;
+            distance[n] = FLT_MAX;
+            for (int cj = j - 1; cj <= j; ++cj) {
+                for (int ci = i - 1; ci <= i; ++ci) {
+                    if (ci < 0 || cj < 0 || ci >= cells || cj >= cells) continue;
+                    for (int k = cellStart[cj * cells + ci]; k < cellStart[cj * cells + ci + 1]; ++k) {
+                        trySegment(segments, k, originX + i * cell, originZ + j * cell, &nearest[n], &distance[n]);
+                    }
+                }
+            }
+        }
+    }
+    static const int sweep[4][2] = { { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+    for (int pass = 0; pass < 2 && segmentCount; ++pass) {
+        int dir = pass ? -1 : 1;
+        for (int jj = 0; jj < SHORE_SDF_RES; ++jj) {
+            int j = pass ? SHORE_SDF_RES - 1 - jj : jj;
+            for (int ii = 0; ii < SHORE_SDF_RES; ++ii) {
+                int i = pass ? SHORE_SDF_RES - 1 - ii : ii;
+                int n = j * SHORE_SDF_RES + i;
+                for (int d = 0; d < 4; ++d) {
+                    int ni = i + dir * sweep[d][0], nj = j + dir * sweep[d][1];
+                    if (ni < 0 || nj < 0 || ni >= SHORE_SDF_RES || nj >= SHORE_SDF_RES) continue;
+                    int k = nearest[nj * SHORE_SDF_RES + ni];
+                    if (k >= 0 && k != nearest[n]) {
+                        trySegment(segments, k, originX + i * cell, originZ + j * cell, &nearest[n], &distance[n]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Exact within SHORE_SDF_MARGIN of the coast: search rings of cells around the sample,
+    // everything in ring r is at least r cells away, so the search stops at the margin or
+    // at the swept distance, whichever is closer
+    for (int j = 0; j < SHORE_SDF_RES && segmentCount; ++j) {
+        for (int i = 0; i < SHORE_SDF_RES; ++i) {
+            int n = j * SHORE_SDF_RES + i;
+            for (int r = 1; r <= cells && r * cell < fminf(distance[n], SHORE_SDF_MARGIN); ++r) {
+                int i0 = i - 1 - r, i1 = i + r, j0 = j - 1 - r, j1 = j + r;
+                for (int cj = j0; cj <= j1; ++cj) {
+                    if (cj < 0 || cj >= cells) continue;
+                    int step = (cj == j0 || cj == j1) ? 1 : i1 - i0;  // Inner rows only have the two ends
+                    for (int ci = i0; ci <= i1; ci += step) {
+                        if (ci < 0 || ci >= cells) continue;
+                        for (int k = cellStart[cj * cells + ci]; k < cellStart[cj * cells + ci + 1]; ++k) {
+                            trySegment(segments, k, originX + i * cell, originZ + j * cell, &nearest[n], &distance[n]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (int j = 0; j < SHORE_SDF_RES; ++j) {
+        for (int i = 0; i < SHORE_SDF_RES; ++i) {
+            int n = j * SHORE_SDF_RES + i;
+
+            // No coast at all: distance to the center keeps the field sensible
+            float px = originX + i * cell;
+            float pz = originZ + j * cell;
+            float best = segmentCount ? distance[n] : sqrtf(px * px + pz * pz);
+
+            bool inside = above[n] > 0.0f;
+            island->shoreSdf[n] = inside ? -best : best;
+        }
+    }
+
+    free(above);
+    free(segments);
+    free(cellStart);
+    free(nearest);
+}
+
+// Bake a 2D signed distance field of the waterline (negative = on land)
+static void bakeShoreSdf(Island* island) {
+    if (island->shape == ISLAND_SHAPE_NOISE) {
+        bakeHeightmapSdf(island);
+        return;
+    }
+
+    float polyX[SHORE_SAMPLES];
+    float polyZ[SHORE_SAMPLES];
+    layoutShoreSdf(island, polyX, polyZ);
+
+    float originX = island->sdfMinX - island->position.x;
+    float originZ = island->sdfMinZ - island->position.z;
+    island->shoreSdf = (float*)arenaAlloc(&island->collisionArena, SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float));
+    if (!island->shoreSdf) return;
+
+    for (int j = 0; j < SHORE_SDF_RES; ++j) {
+        for (int i = 0; i < SHORE_SDF_RES; ++i) {
+            float px = originX + i * island->sdfCellSize;
+            float pz = originZ + j * island->sdfCellSize;
+
+            float best = FLT_MAX;
+            for (int k = 0; k < SHORE_SAMPLES; ++k) {
+                int n = (k + 1) % SHORE_SAMPLES;
+                float d = segmentDistance2D(px, pz, polyX[k], polyZ[k], polyX[n], polyZ[n]);
+                if (d < best) best = d;
+            }
+
+            // Inside test against the exact polar profile
+            float theta = atan2f(pz, px);
+            if (theta < 0.0f) theta += 2.0f * M_PI;
+            bool inside = sqrtf(px * px + pz * pz) < waterlineRadius(island, theta);
+
+            island->shoreSdf[j * SHORE_SDF_RES + i] = inside ? -best : best;
+        }
+    }
+}
+
 // Color based on height
 // Enhanced Color based on height
 static void colorForHeight(Island* island, float height, float* r, float* g, float* b) {
@@ -165,6 +440,7 @@ static void colorForHeight(Island* island, float height, float* r, float* g, flo
     float y = height;
 
     switch (island->colorStyle) {
+    default:  // Never left without a color, whatever the style holds
     case ISLAND_TROPICAL:
         if (y < sandTop) {
             *r = 0.96f; *g = 0.87f; *b = 0.65f;  // Light sand
@@ -211,116 +487,875 @@ static void colorForHeight(Island* island, float height, float* r, float* g, flo
 
 
 
-void initIsland(Island* island, float baseRadius) {
-    if (island->isInitialized) return;
+// Spline profile sampled once per ring angle, shared by every row of the grid
+typedef struct {
+    float cosTheta, sinTheta;
+    float radius, height;
+} RingSample;
+
+// Even (the rows run center to rim over half a turn) and small enough for 16-bit indices
+int clampIslandSegments(int segments) {
+    if (segments <= 0) segments = NUM_SEGMENTS;
+    if (segments < ISLAND_MIN_SEGMENTS) segments = ISLAND_MIN_SEGMENTS;
+    if (segments > ISLAND_MAX_SEGMENTS) segments = ISLAND_MAX_SEGMENTS;
+    return segments & ~1;
+}
 
-    // Seed RNG with unique value for each island
-    unsigned int seed = (unsigned int)time(NULL) ^ (uintptr_t)island;
-    srand(seed);
+// Polar grids wrap around (the last column joins the first), heightmaps don't
+static int islandRows(const Island* island) {
+    return island->shape == ISLAND_SHAPE_NOISE ? island->segments : island->segments / 2 + 1;
+}
 
-    // More color style variation
-    island->colorStyle = rand() % 3;
-    if (rand() % 5 == 0) { // 20% chance of special color style
-        island->colorStyle = rand() % 3; // Re-roll for more variation
-    }
-
-    generateIslandShape(island, baseRadius);
-
-    // Calculate number of vertices needed
-    island->numVertices = NUM_SEGMENTS * (NUM_SEGMENTS / 2) * 4;
-    island->vertices = (IslandVertex*)memalign(32, island->numVertices * sizeof(IslandVertex));
-
-    int vertexIndex = 0;
-
-    for (int i = 0; i < NUM_SEGMENTS; ++i) {
-        float theta1 = (i * 2 * M_PI) / NUM_SEGMENTS;
-        float theta2 = ((i + 1) * 2 * M_PI) / NUM_SEGMENTS;
-
-        for (int j = 0; j < NUM_SEGMENTS / 2; ++j) {
-            float phi1 = (j * M_PI) / NUM_SEGMENTS - M_PI / 2;
-            float phi2 = ((j + 1) * M_PI) / NUM_SEGMENTS - M_PI / 2;
-
-            float cosPhi1 = cosf(phi1);
-            float cosPhi2 = cosf(phi2);
-
-            // Calculate radius at each point
-            float r11 = getInterpolatedRadius(island, theta1) * cosPhi1;
-            float r12 = getInterpolatedRadius(island, theta2) * cosPhi1;
-            float r22 = getInterpolatedRadius(island, theta2) * cosPhi2;
-            float r21 = getInterpolatedRadius(island, theta1) * cosPhi2;
-
-            // Get height offsets
-            float hOffset1 = getInterpolatedHeight(island, theta1);
-            float hOffset2 = getInterpolatedHeight(island, theta2);
-
-            // Base shape is a hemisphere that flattens at the bottom
-            float baseShape1 = (1.0f - cosPhi1 * cosPhi1);  // Flatter at bottom
-            float baseShape2 = (1.0f - cosPhi2 * cosPhi2);
-
-            // Vertex 1
-            IslandVertex* v = &((IslandVertex*)island->vertices)[vertexIndex++];
-            v->position.x = island->position.x + r11 * cosf(theta1);
-            v->position.y = island->position.y + baseShape1 * hOffset1;
-            v->position.z = island->position.z + r11 * sinf(theta1);
-            colorForHeight(island, v->position.y, &v->r, &v->g, &v->b);
-
-            // Vertex 2
-            v = &((IslandVertex*)island->vertices)[vertexIndex++];
-            v->position.x = island->position.x + r12 * cosf(theta2);
-            v->position.y = island->position.y + baseShape1 * hOffset2;
-            v->position.z = island->position.z + r12 * sinf(theta2);
-            colorForHeight(island, v->position.y, &v->r, &v->g, &v->b);
-
-            // Vertex 3
-            v = &((IslandVertex*)island->vertices)[vertexIndex++];
-            v->position.x = island->position.x + r22 * cosf(theta2);
-            v->position.y = island->position.y + baseShape2 * hOffset2;
-            v->position.z = island->position.z + r22 * sinf(theta2);
-            colorForHeight(island, v->position.y, &v->r, &v->g, &v->b);
-
-            // Vertex 4
-            v = &((IslandVertex*)island->vertices)[vertexIndex++];
-            v->position.x = island->position.x + r21 * cosf(theta1);
-            v->position.y = island->position.y + baseShape2 * hOffset1;
-            v->position.z = island->position.z + r21 * sinf(theta1);
-            colorForHeight(island, v->position.y, &v->r, &v->g, &v->b);
-
-            // Create collision triangles
-            Triangle tri1 = {
-                ((IslandVertex*)island->vertices)[vertexIndex - 4].position,
-                ((IslandVertex*)island->vertices)[vertexIndex - 3].position,
-                ((IslandVertex*)island->vertices)[vertexIndex - 2].position
-            };
+static int quadColumns(const Island* island) {
+    return island->shape == ISLAND_SHAPE_NOISE ? island->segments - 1 : island->segments;
+}
+
+static int quadRows(const Island* island) {
+    return islandRows(island) - 1;
+}
+
+// Grid lines a detail level keeps: every stride-th one from 0, always ending on last
+// (for polar columns last is segments, the first column again)
+static int lodSamples(int last, int stride, int* out) {
+    int count = 0;
+    for (int n = 0; n < last; n += stride) out[count++] = n;
+    out[count++] = last;
+    return count;
+}
+
+// Levels that still have a few quads around and one from center to rim
+static int islandLodCount(const Island* island) {
+    int levels = 1;
+    while (levels < ISLAND_LOD_LEVELS &&
+        (quadColumns(island) >> levels) >= 3 && (quadRows(island) >> levels) >= 1) {
+        levels++;
+    }
+    return levels;
+}
+
+// Every quad row of a level is one triangle strip running across all its columns
+static int lodStripLength(const Island* island, int stride) {
+    int columns[ISLAND_MAX_SEGMENTS + 2];
+    return lodSamples(quadColumns(island), stride, columns) * 2;
+}
+
+// Strip j zigzags across quad row j from the last column down: corners 1 and 2 of the
+// last quad, then corners 0 and 3 of every quad. Each quad then splits along the same
+// (i, j)-(i + 1, j + 1) diagonal as the collision triangles, with the same winding: its
+// first strip triangle is (c1, c2, c0) and the second, which GX turns around, (c0, c2, c3)
+// Coarser levels do the same over the rows and columns they keep. Returns the index count
+static int buildLodStrips(const Island* island, int stride, u16* out) {
+    int columns[ISLAND_MAX_SEGMENTS + 2], rows[ISLAND_MAX_SEGMENTS + 2];
+    int numColumns = lodSamples(quadColumns(island), stride, columns);
+    int numRows = lodSamples(quadRows(island), stride, rows);
+
+    int index = 0;
+    for (int j = 0; j + 1 < numRows; ++j) {
+        for (int i = numColumns - 1; i >= 0; --i) {
+            int col = columns[i] % island->segments;
+            out[index++] = (u16)(rows[j] * island->segments + col);
+            out[index++] = (u16)(rows[j + 1] * island->segments + col);
+        }
+    }
+    return index;
+}
+
+// Vertex and index counts of the render mesh, also used to validate cache records
+void islandMeshCounts(IslandShape shape, int segments, int* numVertices, int* numIndices) {
+    if (shape == ISLAND_SHAPE_NOISE) {
+        *numVertices = segments * segments;
+        *numIndices = (segments - 1) * segments * 2;
+    } else {
+        *numVertices = segments * (segments / 2 + 1);
+        *numIndices = (segments / 2) * (segments + 1) * 2;
+    }
+}
+
+static RingSample* sampleRings(Island* island) {
+    RingSample* rings = (RingSample*)malloc(island->segments * sizeof(RingSample));
+    if (!rings) return NULL;
+
+    for (int i = 0; i < island->segments; ++i) {
+        float theta = (i * 2 * M_PI) / island->segments;
+        rings[i].cosTheta = cosf(theta);
+        rings[i].sinTheta = sinf(theta);
+        rings[i].radius = getInterpolatedRadius(island, theta);
+        rings[i].height = getInterpolatedHeight(island, theta);
+    }
+    return rings;
+}
+
+// Heightmap grid: row j along z, column i along x, one noise batch per row
+static bool buildHeightmapGrid(Island* island, Vec3* out) {
+    int res = island->segments;
+    float* rowX = (float*)malloc(res * 3 * sizeof(float));
+    if (!rowX) return false;
+    float* rowZ = rowX + res;
+    float* heights = rowZ + res;
+
+    float step = (2.0f * island->noiseExtent) / (res - 1);
+    for (int i = 0; i < res; ++i) {
+        rowX[i] = -island->noiseExtent + i * step;
+    }
+
+    for (int j = 0; j < res; ++j) {
+        float z = -island->noiseExtent + j * step;
+        for (int i = 0; i < res; ++i) rowZ[i] = z;
+        sampleNoiseHeights(island, rowX, rowZ, heights, res);
+
+        for (int i = 0; i < res; ++i) {
+            Vec3* p = &out[j * res + i];
+            p->x = rowX[i];
+            p->y = heights[i];
+            p->z = z;
+        }
+    }
+
+    free(rowX);
+    return true;
+}
+
+// Shared vertex grid: column i around the island, row j from the center to the rim
+// Base shape is a hemisphere that flattens at the bottom
+static bool buildSurfaceGrid(Island* island, Vec3* out) {
+    if (island->shape == ISLAND_SHAPE_NOISE) return buildHeightmapGrid(island, out);
+
+    RingSample* rings = sampleRings(island);
+    if (!rings) return false;
+
+    int rows = islandRows(island);
+    for (int j = 0; j < rows; ++j) {
+        float phi = (j * M_PI) / island->segments - M_PI / 2;
+        float cosPhi = cosf(phi);
+        float baseShape = (1.0f - cosPhi * cosPhi);  // Flatter at bottom
+
+        for (int i = 0; i < island->segments; ++i) {
+            Vec3* p = &out[j * island->segments + i];
+            float r = rings[i].radius * cosPhi;
+            p->x = r * rings[i].cosTheta;
+            p->y = island->position.y + baseShape * rings[i].height;
+            p->z = r * rings[i].sinTheta;
+        }
+    }
+
+    free(rings);
+    return true;
+}
+
+// Grid index of quad corner k (0..3) for the quad at column i, row j
+static int quadCorner(const Island* island, int i, int j, int k) {
+    int col = (k == 1 || k == 2) ? (i + 1) % island->segments : i;
+    int row = (k >= 2) ? j + 1 : j;
+    return row * island->segments + col;
+}
+
+static s16 quantizeCoord(float steps) {
+    long q = lrintf(steps);
+    if (q > 32767) q = 32767;
+    if (q < -32767) q = -32767;
+    return (s16)q;
+}
+
+// Render grid vertex back in mesh space
+static Vec3 vertexPosition(const Island* island, int index) {
+    const IslandVertex* v = &island->vertices[index];
+    Vec3 p = { v->x * island->positionScale, v->y * island->positionScale, v->z * island->positionScale };
+    return p;
+}
+
+// Instances keep no geometry of their own, queries and drawing go to their archetype
+static Island* geometryOf(Island* island) {
+    return island->archetype ? island->archetype : island;
+}
+
+// World point into the space of the island's geometry: XZ relative to the island and,
+// for instances, the archetype's turn and scale undone (archetypes sit at the origin)
+static Vec3 toIslandSpace(const Island* island, Vec3 p) {
+    p.x -= island->position.x;
+    p.z -= island->position.z;
+    if (!island->archetype) return p;
+
+    float inv = 1.0f / island->scale;
+    Vec3 local = {
+        (island->cosYaw * p.x - island->sinYaw * p.z) * inv,
+        p.y * inv,
+        (island->sinYaw * p.x + island->cosYaw * p.z) * inv
+    };
+    return local;
+}
+
+static Vec3 toWorldSpace(const Island* island, Vec3 p) {
+    if (island->archetype) {
+        Vec3 turned = {
+            (island->cosYaw * p.x + island->sinYaw * p.z) * island->scale,
+            p.y * island->scale,
+            (-island->sinYaw * p.x + island->cosYaw * p.z) * island->scale
+        };
+        p = turned;
+    }
+    p.x += island->position.x;
+    p.z += island->position.z;
+    return p;
+}
+
+// Directions only turn, they keep their length
+static Vec3 directionToIslandSpace(const Island* island, Vec3 d) {
+    if (!island->archetype) return d;
+    Vec3 local = { island->cosYaw * d.x - island->sinYaw * d.z, d.y, island->sinYaw * d.x + island->cosYaw * d.z };
+    return local;
+}
+
+static Vec3 directionToWorldSpace(const Island* island, Vec3 d) {
+    if (!island->archetype) return d;
+    Vec3 turned = { island->cosYaw * d.x + island->sinYaw * d.z, d.y, -island->sinYaw * d.x + island->cosYaw * d.z };
+    return turned;
+}
+
+// Instance bounds: the archetype's box turned and scaled, then boxed again
+static void computeInstanceBounds(Island* island) {
+    const Island* archetype = island->archetype;
+    island->boundsMin = island->position;
+    island->boundsMax = island->position;
+    for (int k = 0; k < 4; ++k) {
+        Vec3 corner = {
+            (k & 1) ? archetype->boundsMax.x : archetype->boundsMin.x,
+            0.0f,
+            (k & 2) ? archetype->boundsMax.z : archetype->boundsMin.z
+        };
+        Vec3 world = toWorldSpace(island, corner);
+        island->boundsMin.x = fminf(island->boundsMin.x, world.x);
+        island->boundsMin.z = fminf(island->boundsMin.z, world.z);
+        island->boundsMax.x = fmaxf(island->boundsMax.x, world.x);
+        island->boundsMax.z = fmaxf(island->boundsMax.z, world.z);
+    }
+    island->boundsMin.y = archetype->boundsMin.y * island->scale;
+    island->boundsMax.y = archetype->boundsMax.y * island->scale;
+}
+
+// Conservative bounds from the control points alone, covering the mesh and the SDF grid
+// Each column spans from the center up to its peak and out to its rim sample
+static void computeIslandBounds(Island* island) {
+    if (island->archetype) {
+        computeInstanceBounds(island);
+        return;
+    }
+
+    island->boundsMin = island->position;
+    island->boundsMax = island->position;
+
+    // Heightmaps are a square from the seabed up to full elevation
+    if (island->shape == ISLAND_SHAPE_NOISE) {
+        layoutHeightmapSdf(island);
+        float sdfExtent = island->sdfCellSize * (SHORE_SDF_RES - 1);
+        island->boundsMin.x = island->sdfMinX;
+        island->boundsMin.z = island->sdfMinZ;
+        island->boundsMax.x = island->sdfMinX + sdfExtent;
+        island->boundsMax.z = island->sdfMinZ + sdfExtent;
+        island->boundsMax.y = island->position.y + island->noiseHeight;
+        return;
+    }
+
+    RingSample* rings = sampleRings(island);
+    for (int i = 0; rings && i < island->segments; ++i) {
+        float x = island->position.x + rings[i].radius * rings[i].cosTheta;
+        float y = island->position.y + rings[i].height;
+        float z = island->position.z + rings[i].radius * rings[i].sinTheta;
+        island->boundsMin.x = fminf(island->boundsMin.x, x);
+        island->boundsMin.y = fminf(island->boundsMin.y, y);
+        island->boundsMin.z = fminf(island->boundsMin.z, z);
+        island->boundsMax.x = fmaxf(island->boundsMax.x, x);
+        island->boundsMax.y = fmaxf(island->boundsMax.y, y);
+        island->boundsMax.z = fmaxf(island->boundsMax.z, z);
+    }
+    free(rings);
+
+    // The SDF grid reaches past the waterline, so the XZ bounds have to cover it too
+    float polyX[SHORE_SAMPLES];
+    float polyZ[SHORE_SAMPLES];
+    layoutShoreSdf(island, polyX, polyZ);
+
+    float sdfExtent = island->sdfCellSize * (SHORE_SDF_RES - 1);
+    island->boundsMin.x = fminf(island->boundsMin.x, island->sdfMinX);
+    island->boundsMin.z = fminf(island->boundsMin.z, island->sdfMinZ);
+    island->boundsMax.x = fmaxf(island->boundsMax.x, island->sdfMinX + sdfExtent);
+    island->boundsMax.z = fmaxf(island->boundsMax.z, island->sdfMinZ + sdfExtent);
+}
+
+// Largest ring radius, i.e. how far the island reaches from its center
+// For a heightmap that is the corner of its square
+static float footprintRadius(Island* island) {
+    if (island->shape == ISLAND_SHAPE_NOISE) return island->noiseExtent * (float)M_SQRT2;
+
+    float radius = 0.0f;
+    RingSample* rings = sampleRings(island);
+    for (int i = 0; rings && i < island->segments; ++i) {
+        if (rings[i].radius > radius) radius = rings[i].radius;
+    }
+    free(rings);
+    return radius;
+}
 
-            Triangle tri2 = {
-                ((IslandVertex*)island->vertices)[vertexIndex - 4].position,
-                ((IslandVertex*)island->vertices)[vertexIndex - 2].position,
-                ((IslandVertex*)island->vertices)[vertexIndex - 1].position
+// Water cover mask and occluder heights from the parameters alone. A mask cell counts
+// when all four of its corners are above WATER_COVER_HEIGHT, and an occluder cell gets
+// the lowest of the corners in it. Corners are evaluated a row at a time, in the
+// geometry's space for instances, whose heights scale about sea level
+static void computeIslandCover(Island* island) {
+    Island* geometry = geometryOf(island);
+    float extent = fmaxf(island->boundsMax.x - island->boundsMin.x, island->boundsMax.z - island->boundsMin.z);
+    island->waterMaskCell = extent / ISLAND_WATER_MASK_RES;
+    memset(island->waterMask, 0, sizeof(island->waterMask));
+
+    const int step = ISLAND_WATER_MASK_RES / ISLAND_OCCLUDER_RES;
+    float lowest[ISLAND_OCCLUDER_RES * ISLAND_OCCLUDER_RES];
+    for (int c = 0; c < ISLAND_OCCLUDER_RES * ISLAND_OCCLUDER_RES; ++c) lowest[c] = FLT_MAX;
+
+    float level = island->archetype ? WATER_COVER_HEIGHT / island->scale : WATER_COVER_HEIGHT;
+    float x[ISLAND_WATER_MASK_RES + 1], z[ISLAND_WATER_MASK_RES + 1], heights[ISLAND_WATER_MASK_RES + 1];
+    bool above[ISLAND_WATER_MASK_RES + 1], aboveBefore[ISLAND_WATER_MASK_RES + 1];
+    for (int j = 0; j <= ISLAND_WATER_MASK_RES; ++j) {
+        for (int i = 0; i <= ISLAND_WATER_MASK_RES; ++i) {
+            Vec3 corner = {
+                island->boundsMin.x + i * island->waterMaskCell,
+                0.0f,
+                island->boundsMin.z + j * island->waterMaskCell
             };
+            Vec3 local = toIslandSpace(island, corner);
+            x[i] = local.x;
+            z[i] = local.z;
+        }
+
+        if (geometry->shape == ISLAND_SHAPE_NOISE) {
+            sampleNoiseHeights(geometry, x, z, heights, ISLAND_WATER_MASK_RES + 1);
+        } else {
+            // Polar surface: position.y + (1 - r^2 / R^2) * H out to the rim radius R
+            for (int i = 0; i <= ISLAND_WATER_MASK_RES; ++i) {
+                float theta = atan2f(z[i], x[i]);
+                if (theta < 0.0f) theta += 2.0f * M_PI;
+                float rim = getInterpolatedRadius(geometry, theta);
+                float r2 = (x[i] * x[i] + z[i] * z[i]) / (rim * rim);
+                heights[i] = geometry->position.y + fmaxf(1.0f - r2, 0.0f) * getInterpolatedHeight(geometry, theta);
+            }
+        }
 
-            island->kdTree = kd_insert(island->kdTree, tri1, 0);
-            island->kdTree = kd_insert(island->kdTree, tri2, 0);
+        for (int i = 0; i <= ISLAND_WATER_MASK_RES; ++i) {
+            // Corners on a cell border belong to the cells on both sides
+            for (int oj = (j - 1) / step; oj <= j / step && oj < ISLAND_OCCLUDER_RES; ++oj) {
+                for (int oi = (i - 1) / step; oi <= i / step && oi < ISLAND_OCCLUDER_RES; ++oi) {
+                    float* cell = &lowest[oj * ISLAND_OCCLUDER_RES + oi];
+                    *cell = fminf(*cell, heights[i]);
+                }
+            }
+
+            above[i] = heights[i] >= level;
+            if (j > 0 && i > 0 && above[i] && above[i - 1] && aboveBefore[i] && aboveBefore[i - 1]) {
+                island->waterMask[j - 1] |= 1u << (i - 1);
+            }
         }
+        memcpy(aboveBefore, above, sizeof(above));
+    }
+
+    float scale = island->archetype ? island->scale : 1.0f;
+    for (int c = 0; c < ISLAND_OCCLUDER_RES * ISLAND_OCCLUDER_RES; ++c) {
+        float steps = floorf((lowest[c] * scale - ISLAND_OCCLUDER_MARGIN) / ISLAND_OCCLUDER_STEP);
+        island->occluderSteps[c] = (u8)fminf(fmaxf(steps, 0.0f), 255.0f);
     }
+}
+
+// Cheap stage: random parameters and bounds only, meshes come later on demand
+void initIsland(Island* island) {
+    if (island->isInitialized) return;
 
+    generateIslandParams(island);
+    finishIslandParams(island);
+}
+
+// Shape and style from the island seed alone, so placement can use the real
+// radius before the island has a position
+void generateIslandParams(Island* island) {
+    // Each island draws from its own stream, so generation order never changes the result
+    Rng rng;
+    rngSeed(&rng, island->seed, RNG_STREAM_SHAPE);
+
+    // Instances only pick a turn and a scale, the rest describes their archetype
+    if (island->archetype) {
+        const Island* archetype = island->archetype;
+        island->yaw = rngFloat(&rng, 0.0f, 2 * M_PI);
+        island->scale = rngFloat(&rng, ISLAND_INSTANCE_MIN_SCALE, ISLAND_INSTANCE_MAX_SCALE);
+        island->cosYaw = cosf(island->yaw);
+        island->sinYaw = sinf(island->yaw);
+        island->colorStyle = archetype->colorStyle;
+        island->shape = archetype->shape;
+        island->segments = archetype->segments;
+        island->radius = archetype->radius * island->scale;
+        return;
+    }
+
+    // More color style variation
+    island->colorStyle = rngRange(&rng, 3);
+    if (rngRange(&rng, 5) == 0) { // 20% chance of special color style
+        island->colorStyle = rngRange(&rng, 3); // Re-roll for more variation
+    }
+
+    if (island->shape == ISLAND_SHAPE_NOISE) {
+        generateNoiseShape(island, &rng);
+    } else {
+        generateIslandShape(island, &rng);
+    }
+
+    island->segments = clampIslandSegments(island->segments);
+    island->radius = footprintRadius(island);
+}
+
+// For islands whose control points were filled in directly (e.g. from a snapshot)
+void finishIslandParams(Island* island) {
+    island->segments = clampIslandSegments(island->segments);
+    computeIslandBounds(island);
+    computeIslandCover(island);
     island->isInitialized = true;
 }
 
-void drawIsland(Island* island) {
-    if (!island->isInitialized) return;
+// Render stage: shared vertex grid plus triangle strip indices
+bool ensureIslandMesh(Island* island) {
+    if (island->archetype) return ensureIslandMesh(island->archetype);
+    if (island->vertices) return true;
+    if (!island->isInitialized) return false;
+
+    // Vertices and indices share one block
+    int numVertices, numIndices;
+    islandMeshCounts(island->shape, island->segments, &numVertices, &numIndices);
+    size_t vertexBytes = numVertices * sizeof(IslandVertex);
+    size_t indexBytes = numIndices * sizeof(u16);
+    arenaReserve(&island->meshArena, vertexBytes + indexBytes + 2 * ARENA_ALIGN);
+    IslandVertex* vertices = (IslandVertex*)arenaAlloc(&island->meshArena, vertexBytes);
+    u16* indices = (u16*)arenaAlloc(&island->meshArena, indexBytes);
+    Vec3* grid = (Vec3*)malloc(numVertices * sizeof(Vec3));
+    if (!vertices || !indices || !grid || !buildSurfaceGrid(island, grid)) {
+        free(grid);
+        arenaReset(&island->meshArena);
+        return false;
+    }
+
+    // One scale for all three axes, picked so the furthest coordinate just fits in s16
+    float extent = 1e-3f;
+    for (int n = 0; n < numVertices; ++n) {
+        extent = fmaxf(extent, fmaxf(fabsf(grid[n].x), fmaxf(fabsf(grid[n].y), fabsf(grid[n].z))));
+    }
+    island->positionScale = extent / 32767.0f;
+    for (int n = 0; n < numVertices; ++n) {
+        float r, g, b;
+        colorForHeight(island, grid[n].y, &r, &g, &b);
+        vertices[n].x = quantizeCoord(grid[n].x / island->positionScale);
+        vertices[n].y = quantizeCoord(grid[n].y / island->positionScale);
+        vertices[n].z = quantizeCoord(grid[n].z / island->positionScale);
+        vertices[n].r = (u8)lrintf(fminf(fmaxf(r, 0.0f), 1.0f) * 255.0f);
+        vertices[n].g = (u8)lrintf(fminf(fmaxf(g, 0.0f), 1.0f) * 255.0f);
+        vertices[n].b = (u8)lrintf(fminf(fmaxf(b, 0.0f), 1.0f) * 255.0f);
+        vertices[n].pad = 0;
+    }
+    free(grid);
+
+    buildLodStrips(island, 1, indices);
+
+    island->vertices = vertices;
+    island->numVertices = numVertices;
+    island->indices = indices;
+    island->numIndices = numIndices;
+    island->meshFromCache = false;
+    return true;
+}
+
+// Step near count / phi that shares no factor with count, so stepping by it
+// visits every index once
+static int scatterStride(int count) {
+    if (count < 3) return 1;
+    int stride = (int)(count * 0.618034f) | 1;
+    for (;;) {
+        int a = stride, b = count;
+        while (b) {
+            int t = a % b;
+            a = b;
+            b = t;
+        }
+        if (a == 1) return stride;
+        stride += 2;
+    }
+}
+
+// Collision stage: kd-tree of the surface triangles plus the shore SDF
+// Unpacks the render grid when it is around, so collision matches what is drawn,
+// otherwise evaluates the surface directly
+bool ensureIslandCollision(Island* island) {
+    if (island->archetype) return ensureIslandCollision(island->archetype);
+    if (island->kdTree.nodes) return true;
+    if (!island->isInitialized) return false;
+
+    int numVertices = island->segments * islandRows(island);
+    Vec3* grid = (Vec3*)malloc(numVertices * sizeof(Vec3));
+    if (!grid) return false;
+    if (island->vertices) {
+        for (int n = 0; n < numVertices; ++n) grid[n] = vertexPosition(island, n);
+    } else if (!buildSurfaceGrid(island, grid)) {
+        free(grid);
+        return false;
+    }
 
-    // Draw all quads
-    for (int i = 0; i < island->numVertices; i += 4) {
-        GX_Begin(GX_QUADS, GX_VTXFMT0, 4);
-        for (int j = 0; j < 4; j++) {
-            IslandVertex* v = &((IslandVertex*)island->vertices)[i + j];
-            GX_Position3f32(v->position.x, v->position.y, v->position.z);
-            GX_Color3f32(v->r, v->g, v->b);
+    // Two collision triangles per quad
+    int rows = quadRows(island);
+    int quads = quadColumns(island) * rows;
+    kd_init(&island->kdTree, quads * 2);
+    if (island->kdTree.nodes) {
+        // Heightmap quads come out sorted along both axes, which turns the insertion-built
+        // kd-tree into a long chain; a golden-ratio stride visits them scattered instead
+        int stride = island->shape == ISLAND_SHAPE_NOISE ? scatterStride(quads) : 1;
+        for (int n = 0, q = 0; n < quads; ++n, q = (q + stride) % quads) {
+            int i = q / rows, j = q % rows;
+            Vec3 a = grid[quadCorner(island, i, j, 0)];
+            Vec3 b = grid[quadCorner(island, i, j, 1)];
+            Vec3 c = grid[quadCorner(island, i, j, 2)];
+            Vec3 d = grid[quadCorner(island, i, j, 3)];
+
+            Triangle tri1 = { a, b, c };
+            Triangle tri2 = { a, c, d };
+            kd_insert(&island->kdTree, tri1);
+            kd_insert(&island->kdTree, tri2);
+        }
+        kd_finish(&island->kdTree);
+    }
+
+    free(grid);
+    if (!island->kdTree.nodes) return false;
+
+    // The finished node array moves into the collision region next to the SDF
+    size_t nodeBytes = island->kdTree.count * sizeof(KDNode);
+    arenaReserve(&island->collisionArena, nodeBytes + SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float) + 2 * ARENA_ALIGN);
+    KDNode* nodes = (KDNode*)arenaAlloc(&island->collisionArena, nodeBytes);
+    if (nodes) memcpy(nodes, island->kdTree.nodes, nodeBytes);
+    kd_free(&island->kdTree);
+    if (!nodes) {
+        arenaReset(&island->collisionArena);
+        return false;
+    }
+    island->kdTree.nodes = nodes;
+    island->kdTree.count = island->kdTree.capacity = (int)(nodeBytes / sizeof(KDNode));
+    island->kdTree.ownsNodes = 0;
+
+    bakeShoreSdf(island);
+    if (!island->shoreSdf) {
+        releaseIslandHeavyData(island);
+        return false;
+    }
+
+    island->collisionFromCache = false;
+    return true;
+}
+
+// What grows at a spot, if anything, by island style and the colorForHeight bands
+static int pickPropArchetype(IslandType style, float height, float slope, Rng* rng) {
+    if (height < 1.2f || slope > 1.2f) return -1;  // Beaches and cliffs stay bare
+
+    int roll = rngRange(rng, 100);
+    switch (style) {
+    case ISLAND_TROPICAL:
+        if (height < 4.5f && slope < 0.6f) return roll < 65 ? PROP_PALM : PROP_BUSH;
+        return roll < 30 ? PROP_ROCK : -1;
+    case ISLAND_VOLCANO:
+        if (height < 2.5f) return roll < 40 ? PROP_ROCK : -1;
+        return roll < 50 ? PROP_BASALT : -1;
+    case ISLAND_ARCTIC:
+        if (slope < 0.8f) return roll < 70 ? PROP_ICE_SPIRE : PROP_ROCK;
+        return roll < 30 ? PROP_ROCK : -1;
+    }
+    return -1;
+}
+
+// Prop stage: instances scattered over the render grid from the island's own stream
+// Attempts are per quad and scale with its area, so the small quads near a polar
+// island's center don't get more than their share
+bool ensureIslandProps(Island* island) {
+    if (island->archetype) return ensureIslandProps(island->archetype);
+    if (island->props.cells) return true;
+    if (!ensureIslandMesh(island)) return false;
+
+    PropInstance* scattered = (PropInstance*)malloc(PROP_MAX_PER_ISLAND * sizeof(PropInstance));
+    u8* archetypes = (u8*)malloc(PROP_MAX_PER_ISLAND);
+    if (!scattered || !archetypes) {
+        free(scattered);
+        free(archetypes);
+        return false;
+    }
+
+    Rng rng;
+    rngSeed(&rng, island->seed, RNG_STREAM_PROPS);
+
+    int count = 0;
+    int rows = quadRows(island);
+    for (int i = 0; i < quadColumns(island); ++i) {
+        for (int j = 0; j < rows; ++j) {
+            Vec3 c[4];
+            for (int k = 0; k < 4; ++k) {
+                c[k] = vertexPosition(island, quadCorner(island, i, j, k));
+            }
+
+            // XZ area from the diagonals, slope as rise over the quad's size
+            float area = 0.5f * fabsf((c[2].x - c[0].x) * (c[3].z - c[1].z) - (c[2].z - c[0].z) * (c[3].x - c[1].x));
+            float lowY = fminf(fminf(c[0].y, c[1].y), fminf(c[2].y, c[3].y));
+            float highY = fmaxf(fmaxf(c[0].y, c[1].y), fmaxf(c[2].y, c[3].y));
+            float slope = (highY - lowY) / sqrtf(fmaxf(area, 1e-4f));
+
+            int attempts = (int)(area * PROP_DENSITY + rngFloat(&rng, 0.0f, 1.0f));
+            for (int n = 0; n < attempts && count < PROP_MAX_PER_ISLAND; ++n) {
+                float u = rngFloat(&rng, 0.0f, 1.0f);
+                float v = rngFloat(&rng, 0.0f, 1.0f);
+                float x = (c[0].x + (c[1].x - c[0].x) * u) * (1.0f - v) + (c[3].x + (c[2].x - c[3].x) * u) * v;
+                float y = (c[0].y + (c[1].y - c[0].y) * u) * (1.0f - v) + (c[3].y + (c[2].y - c[3].y) * u) * v;
+                float z = (c[0].z + (c[1].z - c[0].z) * u) * (1.0f - v) + (c[3].z + (c[2].z - c[3].z) * u) * v;
+
+                int archetype = pickPropArchetype(island->colorStyle, y, slope, &rng);
+                if (archetype < 0) continue;
+
+                PropInstance* prop = &scattered[count];
+                prop->x = (s16)lrintf(x * PROP_POS_SCALE);
+                prop->y = (s16)lrintf(y * PROP_POS_SCALE);
+                prop->z = (s16)lrintf(z * PROP_POS_SCALE);
+                prop->yaw = (u8)rngRange(&rng, 256);
+                prop->scale = (u8)(rngFloat(&rng, 0.7f, 1.3f) * PROP_SCALE_STEP);
+                archetypes[count++] = (u8)archetype;
+            }
+        }
+    }
+
+    bool built = buildPropSet(&island->props, &island->meshArena, scattered, archetypes, count,
+        island->boundsMin.x - island->position.x, island->boundsMin.z - island->position.z,
+        island->boundsMax.x - island->position.x, island->boundsMax.z - island->position.z);
+    free(scattered);
+    free(archetypes);
+    return built;
+}
+
+// Heap memory held by the on-demand stages (cache-backed ones hold none)
+size_t islandHeavyBytes(const Island* island) {
+    return island->meshArena.reserved + island->collisionArena.reserved;
+}
+
+// Drop the on-demand stages; they get rebuilt the next time they are needed
+// Data living in the cache file buffer is just detached
+void releaseIslandHeavyData(Island* island) {
+    island->vertices = NULL;
+    island->indices = NULL;
+    island->numVertices = 0;
+    island->numIndices = 0;
+    island->meshFromCache = false;
+    memset(island->lods, 0, sizeof(island->lods));
+    clearPropSet(&island->props);
+    arenaReset(&island->meshArena);
+
+    kd_free(&island->kdTree);  // Never owns its nodes, they are in the region or the cache
+    island->shoreSdf = NULL;
+    island->collisionFromCache = false;
+    arenaReset(&island->collisionArena);
+}
+
+// Islands get their own vertex format: s16 positions and RGB8 colors, both fetched by
+// 16-bit index from the island's vertex array. Once at startup, next to VTXFMT0
+void setupIslandVertexFormat() {
+    GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_POS, GX_POS_XYZ, GX_S16, 0);
+    GX_SetVtxAttrFmt(GX_VTXFMT1, GX_VA_CLR0, GX_CLR_RGB, GX_RGB8, 0);
+}
+
+// One GX_Begin per strip, every vertex is just its index for position and color
+static void emitIslandStrips(const IslandLod* lod) {
+    for (int i = 0; i < lod->numIndices; i += lod->stripLength) {
+        GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT1, lod->stripLength);
+        for (int j = 0; j < lod->stripLength; j++) {
+            u16 index = lod->indices[i + j];
+            GX_Position1x16(index);
+            GX_Color1x16(index);
         }
         GX_End();
     }
 }
 
+// Bytes the strips take in a display list: a 3 byte primitive header per strip and
+// two 16-bit indices per vertex, padded for GX's 32 byte granularity
+static u32 displayListCapacity(const IslandLod* lod) {
+    int strips = lod->numIndices / lod->stripLength;
+    u32 bytes = strips * 3 + lod->numIndices * 2 * sizeof(u16);
+    return (bytes + 2 * 32 - 1) & ~31u;
+}
+
+// The strips recorded once into the mesh region and replayed with a single call from then on
+static void compileIslandDisplayList(Island* island, IslandLod* lod) {
+    u32 capacity = displayListCapacity(lod);
+    void* list = arenaAlloc(&island->meshArena, capacity);
+    if (!list) return;
+
+    DCInvalidateRange(list, capacity);
+    GX_BeginDisplayList(list, capacity);
+    emitIslandStrips(lod);
+    u32 size = GX_EndDisplayList();
+    if (size == 0) return;  // Overflowed, the strips keep going out directly
+
+    lod->displayList = list;
+    lod->displayListSize = size;
+}
+
+// A level's strips and display list, made the first time it is drawn; level 0 uses the
+// mesh's own indices. GX is only ever driven from the main thread, so this happens on
+// draw, never in a worker. Falls back to level 0 when the region is out of memory
+static IslandLod* islandLod(Island* island, int level) {
+    IslandLod* lod = &island->lods[level];
+    if (lod->built) return lod->indices ? lod : islandLod(island, 0);
+    lod->built = true;
+
+    // New strips usually mean a new mesh: the GP reads the vertex array from memory,
+    // and may still hold vertices of whatever was at these addresses before
+    DCFlushRange(island->vertices, island->numVertices * sizeof(IslandVertex));
+    GX_InvVtxCache();
+
+    int stride = 1 << level;
+    lod->stripLength = lodStripLength(island, stride);
+    if (level == 0) {
+        lod->indices = island->indices;
+        lod->numIndices = island->numIndices;
+    } else {
+        int rows[ISLAND_MAX_SEGMENTS + 2];
+        int count = (lodSamples(quadRows(island), stride, rows) - 1) * lod->stripLength;
+        lod->indices = (u16*)arenaAlloc(&island->meshArena, count * sizeof(u16));
+        if (!lod->indices) return islandLod(island, 0);
+        lod->numIndices = buildLodStrips(island, stride, lod->indices);
+    }
+
+    compileIslandDisplayList(island, lod);
+    return lod;
+}
+
+// Level by the on-screen size of an average grid quad, against the distance to the bounds
+// A level only changes once the size is ISLAND_LOD_HYSTERESIS past the target, so
+// an island hovering around a switching distance doesn't pop back and forth
+static int pickIslandLod(Island* island, const Island* geometry, Vec3 viewPos) {
+    float dx = fmaxf(fmaxf(island->boundsMin.x - viewPos.x, 0.0f), viewPos.x - island->boundsMax.x);
+    float dy = fmaxf(fmaxf(island->boundsMin.y - viewPos.y, 0.0f), viewPos.y - island->boundsMax.y);
+    float dz = fmaxf(fmaxf(island->boundsMin.z - viewPos.z, 0.0f), viewPos.z - island->boundsMax.z);
+    float distance = fmaxf(sqrtf(dx * dx + dy * dy + dz * dz), 1.0f);
+
+    float quadSize = island->radius * sqrtf(M_PI / (quadColumns(geometry) * quadRows(geometry)));
+    float pixels = quadSize * ISLAND_LOD_PROJECTION / distance;
+
+    int levels = islandLodCount(geometry);
+    int level = island->lodLevel < levels ? island->lodLevel : levels - 1;
+    while (level > 0 && pixels * (1 << level) > ISLAND_LOD_PIXELS * (1.0f + ISLAND_LOD_HYSTERESIS)) level--;
+    while (level + 1 < levels && pixels * (2 << level) < ISLAND_LOD_PIXELS * (1.0f - ISLAND_LOD_HYSTERESIS)) level++;
+    return level;
+}
+
+// Island space to world: the XZ offset, plus the turn and scale of an instance
+static void islandModelMatrix(const Island* island, Mtx out) {
+    guMtxTrans(out, island->position.x, 0.0f, island->position.z);
+    if (island->archetype) {
+        Mtx turn, placed;
+        guMtxRotRad(turn, 'y', island->yaw);
+        guMtxScaleApply(turn, turn, island->scale, island->scale, island->scale);
+        guMtxConcat(out, turn, placed);
+        guMtxCopy(placed, out);
+    }
+}
+
+// modelview is the shared one, the island's offset (and an instance's turn and scale) goes on top of it
+// The level of detail is picked from viewPos
+void drawIsland(Island* island, Mtx modelview, Vec3 viewPos) {
+    if (!ensureIslandMesh(island)) return;
+
+    Mtx offset, islandView;
+    islandModelMatrix(island, offset);
+    guMtxConcat(modelview, offset, islandView);
+
+    // Position steps to mesh units goes on top, only while the mesh is drawn
+    Island* geometry = geometryOf(island);
+    Mtx meshView, steps;
+    float step = geometry->positionScale;
+    guMtxScale(steps, step, step, step);
+    guMtxConcat(islandView, steps, meshView);  // Not guMtxScaleApply, that scales the view-space translation too
+    GX_LoadPosMtxImm(meshView, GX_PNMTX0);
+
+    GX_SetVtxDesc(GX_VA_POS, GX_INDEX16);
+    GX_SetVtxDesc(GX_VA_CLR0, GX_INDEX16);
+    GX_SetArray(GX_VA_POS, geometry->vertices, sizeof(IslandVertex));
+    GX_SetArray(GX_VA_CLR0, &geometry->vertices[0].r, sizeof(IslandVertex));
+
+    // Instances pick their own level and replay their archetype's list for it
+    island->lodLevel = pickIslandLod(island, geometry, viewPos);
+    IslandLod* lod = islandLod(geometry, island->lodLevel);
+    profileCount(PROF_ISLAND_VERTS_DRAWN, lod->numIndices);
+    if (lod->displayList) {
+        GX_CallDispList(lod->displayList, lod->displayListSize);
+    } else {
+        emitIslandStrips(lod);
+    }
+
+    // Back to direct f32 vertices for everything else, with the island's own matrix for its props
+    GX_SetVtxDesc(GX_VA_POS, GX_DIRECT);
+    GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+    GX_LoadPosMtxImm(islandView, GX_PNMTX0);
+}
+
+// Expects drawIsland's matrix to still be loaded; props are in the same space as the mesh
+void drawIslandProps(Island* island, Vec3 viewPos, const OcclusionBuffer* occlusion) {
+    if (!ensureIslandProps(island)) return;
+
+    Mtx model;
+    islandModelMatrix(island, model);
+    Vec3 view = toIslandSpace(island, viewPos);
+    float range = island->archetype ? PROP_DRAW_DISTANCE / island->scale : PROP_DRAW_DISTANCE;
+    drawPropSet(&geometryOf(island)->props, view.x, view.z, range, occlusion, model);
+}
+
+// Straight from the parameters: one box per run of equally high occluder cells in a row
+void addIslandOccluders(const Island* island, OcclusionBuffer* buffer) {
+    float cell = island->waterMaskCell * (ISLAND_WATER_MASK_RES / ISLAND_OCCLUDER_RES);
+    for (int j = 0; j < ISLAND_OCCLUDER_RES; ++j) {
+        const u8* row = &island->occluderSteps[j * ISLAND_OCCLUDER_RES];
+        int i = 0;
+        while (i < ISLAND_OCCLUDER_RES) {
+            int start = i++;
+            while (i < ISLAND_OCCLUDER_RES && row[i] == row[start]) ++i;
+            if (row[start] == 0) continue;
+
+            Vec3 min = { island->boundsMin.x + start * cell, SEA_LEVEL, island->boundsMin.z + j * cell };
+            Vec3 max = { island->boundsMin.x + i * cell, row[start] * ISLAND_OCCLUDER_STEP, min.z + cell };
+            addOccluderBox(buffer, min, max);
+        }
+    }
+}
+
+// Whether the rectangle (same space as position) lies entirely on covered mask cells
+bool islandCoversRect(const Island* island, float minX, float minZ, float maxX, float maxZ) {
+    if (island->waterMaskCell <= 0.0f) return false;
+    float inv = 1.0f / island->waterMaskCell;
+    int i0 = (int)floorf((minX - island->boundsMin.x) * inv);
+    int j0 = (int)floorf((minZ - island->boundsMin.z) * inv);
+    int i1 = (int)ceilf((maxX - island->boundsMin.x) * inv) - 1;
+    int j1 = (int)ceilf((maxZ - island->boundsMin.z) * inv) - 1;
+    if (i0 < 0 || j0 < 0 || i1 >= ISLAND_WATER_MASK_RES || j1 >= ISLAND_WATER_MASK_RES) return false;
+
+    u32 bits = (i1 - i0 == 31) ? 0xFFFFFFFFu : ((1u << (i1 - i0 + 1)) - 1) << i0;
+    for (int j = j0; j <= j1; ++j) {
+        if ((island->waterMask[j] & bits) != bits) return false;
+    }
+    return true;
+}
+
+// Move the island without touching its geometry, which is relative to position
+void shiftIsland(Island* island, float dx, float dz) {
+    island->position.x += dx;
+    island->position.z += dz;
+    island->boundsMin.x += dx;
+    island->boundsMin.z += dz;
+    island->boundsMax.x += dx;
+    island->boundsMax.z += dz;
+    island->sdfMinX += dx;
+    island->sdfMinZ += dz;
+}
+
 
 // Helper function: Find closest point on triangle to a point
 static Vec3 closestPointOnTriangle(Vec3 p, Triangle tri) {
@@ -406,101 +1441,116 @@ static float dot(Vec3 a, Vec3 b) {
     return a.x * b.x + a.y * b.y + a.z * b.z;
 }
 
-// Helper: cross product
-static Vec3 cross(Vec3 a, Vec3 b) {
-    return (Vec3) {
-        a.y* b.z - a.z * b.y,
-            a.z* b.x - a.x * b.z,
-            a.x* b.y - a.y * b.x
-    };
+// Bilinear sample of the shore SDF at grid coordinates (u, v), clamped to the grid
+static float sampleShoreSdf(const Island* island, float u, float v) {
+    float maxCoord = (float)(SHORE_SDF_RES - 1);
+    if (u < 0.0f) u = 0.0f;
+    if (v < 0.0f) v = 0.0f;
+    if (u > maxCoord) u = maxCoord;
+    if (v > maxCoord) v = maxCoord;
+
+    int i0 = (int)u, j0 = (int)v;
+    int i1 = i0 < SHORE_SDF_RES - 1 ? i0 + 1 : i0;
+    int j1 = j0 < SHORE_SDF_RES - 1 ? j0 + 1 : j0;
+    float fu = u - i0, fv = v - j0;
+
+    const float* sdf = island->shoreSdf;
+    float top = sdf[j0 * SHORE_SDF_RES + i0] * (1.0f - fu) + sdf[j0 * SHORE_SDF_RES + i1] * fu;
+    float bottom = sdf[j1 * SHORE_SDF_RES + i0] * (1.0f - fu) + sdf[j1 * SHORE_SDF_RES + i1] * fu;
+    return top * (1.0f - fv) + bottom * fv;
 }
 
-// Ray-triangle intersection (MllerTrumbore algorithm)
-static bool ray_intersects_triangle(Vec3 orig, Vec3 dir, const Triangle* tri, float maxDist) {
-    const float EPSILON = 1e-6f;
-    Vec3 v0v1 = subtract(tri->v2, tri->v1);
-    Vec3 v0v2 = subtract(tri->v3, tri->v1);
-    Vec3 pvec = cross(dir, v0v2);
-    float det = dot(v0v1, pvec);
+// Signed distance from (x, z) to the island's waterline, negative on land
+// gradient (optional) gets the XZ direction pointing away from the coast
+float islandShoreDistance(Island* island, float x, float z, Vec3* gradient) {
+    if (!island || !ensureIslandCollision(island)) return FLT_MAX;
+
+    // Distances scale with the instance, the gradient only turns
+    if (island->archetype) {
+        Vec3 local = toIslandSpace(island, (Vec3) { x, 0.0f, z });
+        float dist = islandShoreDistance(island->archetype, local.x, local.z, gradient);
+        if (gradient) *gradient = directionToWorldSpace(island, *gradient);
+        return dist * island->scale;
+    }
 
-    if (fabsf(det) < EPSILON) return false;
+    float u = (x - island->sdfMinX) / island->sdfCellSize;
+    float v = (z - island->sdfMinZ) / island->sdfCellSize;
+    float maxCoord = (float)(SHORE_SDF_RES - 1);
 
-    float invDet = 1.0f / det;
-    Vec3 tvec = subtract(orig, tri->v1);
-    float u = dot(tvec, pvec) * invDet;
-    if (u < 0 || u > 1) return false;
+    float dist = sampleShoreSdf(island, u, v);
 
-    Vec3 qvec = cross(tvec, v0v1);
-    float v = dot(dir, qvec) * invDet;
-    if (v < 0 || u + v > 1) return false;
+    // Outside the baked area: add the distance back to the grid edge (stays conservative)
+    float cu = u < 0.0f ? 0.0f : (u > maxCoord ? maxCoord : u);
+    float cv = v < 0.0f ? 0.0f : (v > maxCoord ? maxCoord : v);
+    bool outsideGrid = (cu != u || cv != v);
+    if (outsideGrid) {
+        float du = (u - cu) * island->sdfCellSize;
+        float dv = (v - cv) * island->sdfCellSize;
+        dist += sqrtf(du * du + dv * dv);
+    }
 
-    float t = dot(v0v2, qvec) * invDet;
-    return (t > EPSILON && t < maxDist);
-}
+    if (gradient) {
+        float gx, gz;
+        if (outsideGrid) {
+            gx = x - island->position.x;
+            gz = z - island->position.z;
+        } else {
+            gx = sampleShoreSdf(island, u + 0.5f, v) - sampleShoreSdf(island, u - 0.5f, v);
+            gz = sampleShoreSdf(island, u, v + 0.5f) - sampleShoreSdf(island, u, v - 0.5f);
+        }
+        float len = sqrtf(gx * gx + gz * gz);
+        gradient->x = len > 0.0f ? gx / len : 0.0f;
+        gradient->y = 0.0f;
+        gradient->z = len > 0.0f ? gz / len : 0.0f;
+    }
 
-// Context for KD-tree callback
-typedef struct {
-    Vec3 origin;
-    Vec3 direction;
-    float maxDist;
-    bool blocked;
-} RayCheckContext;
+    return dist;
+}
 
-// Static callback wrapper
-static RayCheckContext* ray_context = NULL;
+// Distance to the first island triangle along a normalized ray, maxDist if nothing is hit
+float islandRaycast(Island* island, Vec3 origin, Vec3 dir, float maxDist) {
+    if (!island || !ensureIslandCollision(island)) return maxDist;
 
-static void ray_query_callback(const Triangle* tri) {
-    if (ray_intersects_triangle(ray_context->origin, ray_context->direction, tri, ray_context->maxDist)) {
-        ray_context->blocked = true;
+    // Triangles are island-relative; an instance's ray is taken into archetype space,
+    // where its length shrinks by the scale
+    origin = toIslandSpace(island, origin);
+    if (island->archetype) {
+        dir = directionToIslandSpace(island, dir);
+        return kd_raycast(&island->archetype->kdTree, origin, dir, maxDist / island->scale) * island->scale;
     }
+    return kd_raycast(&island->kdTree, origin, dir, maxDist);
 }
 
 bool cameraCoveredCheck(Vec3 cameraPos, Vec3 playerPos, Island* island) {
-    if (!island || !island->kdTree) return false;
+    if (!island || !ensureIslandCollision(island)) return false;
 
     Vec3 dir = subtract(playerPos, cameraPos);
     float distance = sqrtf(dot(dir, dir));
+    if (distance <= 0.0f) return false;
     dir = normalize(dir);
 
-    RayCheckContext context = {
-        .origin = cameraPos,
-        .direction = dir,
-        .maxDist = distance,
-        .blocked = false
-    };
-
-    ray_context = &context;
-
-    Vec3 middleCameraPlayer = {
-        ((playerPos.x + cameraPos.x) / 2),
-        ((playerPos.y + cameraPos.y) / 2),
-        ((playerPos.z + cameraPos.z) / 2)
-    };
-
-    // Search the 3 closest triangles instead of radius-based search
-    kd_query_nearest(island->kdTree, middleCameraPlayer, 10, ray_query_callback);
-
-    ray_context = NULL;
-
-    return context.blocked;
+    return islandRaycast(island, cameraPos, dir, distance) < distance;
 }
 
 
-// debug draw triangle colliding with
-void drawCollidingTriangle(const Triangle* tri) {
+// debug draw triangle colliding with, tri is in the island's geometry space
+void drawCollidingTriangle(const Triangle* tri, const Island* island) {
     if (!tri) return;
 
     float change = 0.05f;
+    Vec3 v1 = toWorldSpace(island, tri->v1);
+    Vec3 v2 = toWorldSpace(island, tri->v2);
+    Vec3 v3 = toWorldSpace(island, tri->v3);
 
     GX_Begin(GX_TRIANGLES, GX_VTXFMT0, 3);
 
-    GX_Position3f32(tri->v1.x, tri->v1.y + change, tri->v1.z);
+    GX_Position3f32(v1.x, v1.y + change, v1.z);
     GX_Color3f32(1.0f, 0.0f, 0.0f);  // Red
 
-    GX_Position3f32(tri->v2.x, tri->v2.y + change, tri->v2.z);
+    GX_Position3f32(v2.x, v2.y + change, v2.z);
     GX_Color3f32(0.0f, 1.0f, 0.0f);  // Green
 
-    GX_Position3f32(tri->v3.x, tri->v3.y + change, tri->v3.z);
+    GX_Position3f32(v3.x, v3.y + change, v3.z);
     GX_Color3f32(0.0f, 0.0f, 1.0f);  // Blue
 
     GX_End();
@@ -509,7 +1559,7 @@ void drawCollidingTriangle(const Triangle* tri) {
 // Ground/wall collision
 // Checks if a sphere at `position` with `radius` intersects the terrain of the island
 bool checkIslandCollision(Island* island, Vec3 position, float radius) {
-    if (!island || !island->kdTree) return false;
+    if (!island || !ensureIslandCollision(island)) return false;
 
     typedef struct {
         Vec3 center;
@@ -517,6 +1567,11 @@ bool checkIslandCollision(Island* island, Vec3 position, float radius) {
         bool collided;
     } CollisionContext;
 
+    // Triangles are island-relative (archetype space for instances, where the squared
+    // distance test below shrinks with the scale squared)
+    position = toIslandSpace(island, position);
+    if (island->archetype) radius /= island->scale * island->scale;
+
     CollisionContext context = {
         .center = position,
         .radius = radius,
@@ -528,20 +1583,20 @@ bool checkIslandCollision(Island* island, Vec3 position, float radius) {
         Vec3 diff = subtract(context.center, closest);
         float distSq = dot(diff, diff);
         if (distSq <= context.radius / 2) {
-            drawCollidingTriangle(tri);
+            drawCollidingTriangle(tri, island);
             context.collided = true;
         }
     }
 
     // Query the 3 closest triangles regardless of actual range
-    kd_query_nearest(island->kdTree, position, 10, collisionCallback);
+    kd_query_nearest(&geometryOf(island)->kdTree, position, 10, collisionCallback);
 
     return context.collided;
 }
 
 // Absolutly broken I am very mad, ai sucks at coding, never again
 float getIslandTriangleHeight(Island* island, Vec3 position, float radius) {
-    if (!island || !island->kdTree) return false;
+    if (!island || !ensureIslandCollision(island)) return false;
 
     typedef struct {
         Vec3 center;
@@ -549,6 +1604,9 @@ float getIslandTriangleHeight(Island* island, Vec3 position, float radius) {
         float height;
     } CollisionContext;
 
+    position = toIslandSpace(island, position);
+    if (island->archetype) radius /= island->scale * island->scale;
+
     CollisionContext context = {
         .center = position,
         .radius = radius,
@@ -560,15 +1618,15 @@ float getIslandTriangleHeight(Island* island, Vec3 position, float radius) {
         Vec3 diff = subtract(context.center, closest);
         float distSq = dot(diff, diff);
         if (distSq <= context.radius / 2) {
-            drawCollidingTriangle(tri);
+            drawCollidingTriangle(tri, island);
             context.height = tri->v2.y;
         }
     }
 
     // Query the 3 closest triangles regardless of actual range
-    kd_query_nearest(island->kdTree, position, 1, collisionCallback);
+    kd_query_nearest(&geometryOf(island)->kdTree, position, 1, collisionCallback);
 
-    return context.height;
+    return island->archetype ? context.height * island->scale : context.height;
 }
 
 
@@ -583,15 +1641,6 @@ float getIslandTriangleHeight(Island* island, Vec3 position, float radius) {
 void freeIslandResources(Island* island) {
     if (!island) return;
 
-    if (island->kdTree) {
-        kd_free(island->kdTree);
-        island->kdTree = NULL;
-    }
-
-    if (island->vertices) {
-        free(island->vertices);
-        island->vertices = NULL;
-    }
-
+    releaseIslandHeavyData(island);
     island->isInitialized = false;
-}
\ No newline at end of file
+}
@@ -3,9 +3,64 @@
 
 #include "common.h"
 #include "kd_tree.h"
+#include "noise.h"
+#include "arena.h"
+#include "props.h"
+#include "occlusion.h"
 
 #define NUM_CTRL_POINTS 12
-#define NUM_SEGMENTS 32
+#define NUM_SEGMENTS 32          // Default tessellation, islands can override it
+#define ISLAND_MIN_SEGMENTS 4
+#define ISLAND_MAX_SEGMENTS 256  // Keeps the vertex grid within 16-bit indices
+
+// Heightmap islands from 2D fractal noise, next to the polar ones
+#define ISLAND_HEIGHTMAP_RES   64  // Default heightmap samples per side
+#define ISLAND_NOISE_PERCENT   30  // Share of islands the noise generator makes
+
+// Level of detail: coarser levels reuse the vertex grid, keeping every 2nd, 4th and 8th
+// row and column
+#define ISLAND_LOD_LEVELS      4
+#define ISLAND_LOD_PIXELS      32.0f   // On-screen size a grid quad is kept around
+#define ISLAND_LOD_HYSTERESIS  0.25f   // Band around it before the level changes
+#define ISLAND_LOD_PROJECTION  580.0f  // Pixels per unit at distance 1: 240 lines over tan(22.5 deg)
+
+// Instances reuse a library archetype turned about y and scaled about sea level
+#define ISLAND_INSTANCE_MIN_SCALE  0.7f
+#define ISLAND_INSTANCE_MAX_SCALE  1.2f
+
+// Water cover mask: a grid over the XZ bounds marking where the surface stays above the
+// highest wave, so the water under it can't show
+#define ISLAND_WATER_MASK_RES  32  // Cells per side, one bit each
+#define WATER_COVER_HEIGHT     (2.0f * WAVE_AMPLITUDE + 0.25f)
+
+// Occluders: boxes from sea level up to the lowest surface point over each cell of a
+// coarser grid on the same area, so they stay inside the island
+#define ISLAND_OCCLUDER_RES     16     // Cells per side, each over 2x2 mask cells
+#define ISLAND_OCCLUDER_STEP    1.0f   // Box tops round down to whole steps, so rows merge into few boxes
+#define ISLAND_OCCLUDER_MARGIN  0.5f   // Taken off the sampled minimum for dips between samples
+
+// Shoreline signed distance field (2D, XZ plane at sea level)
+#define SHORE_SDF_RES     64    // Grid samples per side
+#define SHORE_SDF_MARGIN  4.0f  // Extra distance baked around the waterline
+#define SHORE_SAMPLES     64    // Waterline polygon samples used for baking
+
+// Mesh and collision geometry is relative to the island's XZ position, so
+// moving the island (origin rebasing) never touches it
+// 10 bytes: fixed-point position in steps of the island's positionScale, RGB8 color
+typedef struct {
+    s16 x, y, z;
+    u8 r, g, b;
+    u8 pad;
+} IslandVertex;
+
+typedef struct {
+    u16* indices;  // Level 0 points at the mesh's own, the others live in the mesh region
+    int numIndices;
+    int stripLength;
+    void* displayList;  // NULL if it could not be compiled
+    u32 displayListSize;
+    bool built;  // Made on the first draw at this level
+} IslandLod;
 
 typedef enum {
     ISLAND_TROPICAL,
@@ -13,23 +68,100 @@ typedef enum {
     ISLAND_ARCTIC
 } IslandType;
 
-typedef struct {
+typedef enum {
+    ISLAND_SHAPE_POLAR,  // Control point profile around the center
+    ISLAND_SHAPE_NOISE   // Square heightmap of domain-warped fractal noise
+} IslandShape;
+
+typedef struct Island Island;
+
+struct Island {
     Vec3 position;
-    float radius;
+    float radius;  // Furthest the shoreline profile reaches from position
     bool isInitialized;
     IslandType colorStyle;
-    KDNode* kdTree;
-    void* vertices;  // Opaque pointer to vertex data
+    u64 seed;  // Derived from the world seed and island index
+    KDTree kdTree;
+    IslandShape shape;
+    int segments;  // Polar: samples around the island, half as many rows from center to rim
+                   // Noise: heightmap samples per side
+
+    // Noise shape only
+    NoiseParams noise;
+    float noiseExtent;  // Half side of the heightmap square
+    float noiseHeight;  // Height above the seabed at full elevation
+
+    // Instances have no geometry of their own: the archetype's is drawn and queried
+    // through their turn and scale, and none of the stages below are ever built
+    Island* archetype;   // NULL for islands with their own geometry
+    int archetypeIndex;  // Into the island library, stored by the cache
+    float yaw, scale;
+    float cosYaw, sinYaw;
+
+    // Shared vertex grid (row-major, segments per row) and one triangle strip per quad row
+    IslandVertex* vertices;
     int numVertices;
+    float positionScale;  // World units per position step
+    u16* indices;
+    int numIndices;
+
+    // Strips per detail level, compiled for GX on first draw
+    IslandLod lods[ISLAND_LOD_LEVELS];
+    int lodLevel;  // Last one drawn, per instance as they are each at their own distance
     float ctrlRadius[NUM_CTRL_POINTS];
     float ctrlHeight[NUM_CTRL_POINTS];
-} Island;
 
-void initIsland(Island* island, float baseRadius);
-void drawIsland(Island* island);
+    // Waterline SDF, negative inside the coast
+    float* shoreSdf;
+    float sdfMinX, sdfMinZ;
+    float sdfCellSize;
+
+    // Scattered over the render grid, shares the mesh region
+    PropSet props;
+
+    // Conservative bounds of the mesh and shore SDF, same space as position
+    Vec3 boundsMin, boundsMax;
+
+    // Row j, bit i is the cell at boundsMin + (i, j) * waterMaskCell
+    u32 waterMask[ISLAND_WATER_MASK_RES];
+    float waterMaskCell;
+
+    // Occluder box tops in ISLAND_OCCLUDER_STEPs above sea level, row by row over the
+    // same area, 0 for none
+    u8 occluderSteps[ISLAND_OCCLUDER_RES * ISLAND_OCCLUDER_RES];
+
+    unsigned int queryStamp;  // Last broad-phase query that visited this island
+    unsigned int lastUsedFrame;  // Last frame the mesh or collision data was touched
+
+    // Built on demand; cached stages live in the chunk's cache buffer,
+    // built ones in a region per stage that is dropped in one go
+    bool meshFromCache;
+    bool collisionFromCache;
+    Arena meshArena;
+    Arena collisionArena;
+};
+
+void initIsland(Island* island);
+void generateIslandParams(Island* island);
+void finishIslandParams(Island* island);
+int clampIslandSegments(int segments);
+void islandMeshCounts(IslandShape shape, int segments, int* numVertices, int* numIndices);
+bool ensureIslandMesh(Island* island);
+bool ensureIslandCollision(Island* island);
+bool ensureIslandProps(Island* island);
+size_t islandHeavyBytes(const Island* island);
+void releaseIslandHeavyData(Island* island);
+void setupIslandVertexFormat();
+void drawIsland(Island* island, Mtx modelview, Vec3 viewPos);
+void drawIslandProps(Island* island, Vec3 viewPos, const OcclusionBuffer* occlusion);
+void addIslandOccluders(const Island* island, OcclusionBuffer* buffer);
+void shiftIsland(Island* island, float dx, float dz);
+bool islandCoversRect(const Island* island, float minX, float minZ, float maxX, float maxZ);
 bool checkIslandCollision(Island* island, Vec3 position, float radius);
 float getIslandTriangleHeight(Island* island, Vec3 position, float radius);
 void freeIslandResources(Island* island);
+float islandShoreDistance(Island* island, float x, float z, Vec3* gradient);
+float islandRaycast(Island* island, Vec3 origin, Vec3 dir, float maxDist);
 bool cameraCoveredCheck(Vec3 cameraPos, Vec3 playerPos, Island* island);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include "islandCache.h"
+#include "rng.h"
+#include "placement.h"
+#include "islandLibrary.h"
+
+// File layout: header, one record per island, then the 32-byte aligned
+// vertex, index, kd-node and SDF arrays each record points at (offsets from file start).
+// The whole file is read with a single fread and used in place.
+// Only the stages that were built get stored; a zero count means build on demand.
+// Positions and bounds are relative to the chunk center, so files don't depend on the origin.
+// Instances store their archetype, turn and scale and never any arrays.
+typedef struct {
+    u32 magic;
+    u32 version;
+    u64 worldSeed;
+    s32 chunkX, chunkZ;
+    u32 paramsHash;
+    u32 islandCount;
+    u32 fileSize;
+    u32 reserved;
+} IslandCacheHeader;
+
+typedef struct {
+    Vec3 position;
+    float radius;
+    u32 colorStyle;
+    u64 seed;
+    u32 shape;
+    u32 segments;
+    NoiseParams noise;
+    float noiseExtent, noiseHeight;
+    float ctrlRadius[NUM_CTRL_POINTS];
+    float ctrlHeight[NUM_CTRL_POINTS];
+    Vec3 boundsMin, boundsMax;
+    float sdfMinX, sdfMinZ, sdfCellSize;
+    u32 waterMask[ISLAND_WATER_MASK_RES];
+    float waterMaskCell;
+    u8 occluderSteps[ISLAND_OCCLUDER_RES * ISLAND_OCCLUDER_RES];
+    s32 archetype;  // Library index, -1 for islands with their own geometry
+    float yaw, scale;
+
+    float positionScale;
+    u32 numVertices;
+    u32 vertexOffset;
+    u32 numIndices;
+    u32 indexOffset;
+    u32 nodeCount;
+    u32 nodeOffset;
+    u32 sdfOffset;
+} IslandCacheRecord;
+
+static u32 hashValue(u32 hash, u32 value) {
+    return (u32)rngMix(((u64)hash << 32) | value);
+}
+
+static u32 hashFloat(u32 hash, float value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hashValue(hash, bits);
+}
+
+// Everything that changes what generation produces; a mismatch invalidates the file
+static u32 generationParamsHash(const ChunkSettings* settings) {
+    u32 hash = ISLAND_CACHE_VERSION;
+    hash = hashValue(hash, NUM_CTRL_POINTS);
+    hash = hashValue(hash, NUM_SEGMENTS);
+    hash = hashValue(hash, sizeof(IslandCacheRecord));
+    hash = hashValue(hash, SHORE_SDF_RES);
+    hash = hashValue(hash, SHORE_SAMPLES);
+    hash = hashValue(hash, settings->islandsPerChunk);
+    hash = hashValue(hash, settings->islandSegments);
+    hash = hashValue(hash, settings->heightmapResolution);
+    hash = hashValue(hash, settings->noiseIslandPercent);
+    hash = hashValue(hash, settings->instancedIslandPercent);
+    hash = hashValue(hash, ISLAND_LIBRARY_SIZE);
+    hash = hashValue(hash, (u32)ISLAND_LIBRARY_SEED);
+    hash = hashFloat(hash, ISLAND_INSTANCE_MIN_SCALE);
+    hash = hashFloat(hash, ISLAND_INSTANCE_MAX_SCALE);
+    hash = hashValue(hash, NOISE_MAX_OCTAVES);
+    hash = hashValue(hash, PLACEMENT_ATTEMPTS);
+    hash = hashValue(hash, PLACEMENT_MAX_CELLS);
+    hash = hashFloat(hash, settings->chunkSize);
+    hash = hashFloat(hash, ISLAND_MIN_GAP);
+    hash = hashValue(hash, sizeof(IslandVertex));
+    hash = hashValue(hash, sizeof(KDNode));
+    hash = hashFloat(hash, SHORE_SDF_MARGIN);
+    hash = hashFloat(hash, ISLAND_MIN_RADIUS);
+    hash = hashFloat(hash, ISLAND_MAX_RADIUS);
+    hash = hashFloat(hash, ISLAND_MIN_HEIGHT);
+    hash = hashFloat(hash, ISLAND_MAX_HEIGHT);
+    hash = hashFloat(hash, SEA_LEVEL);
+    return hash;
+}
+
+static void cachePath(char* out, size_t size, const IslandChunk* chunk) {
+    snprintf(out, size, "%s/world_%08x%08x_%d_%d.bin", ISLAND_CACHE_DIR,
+        (unsigned int)(chunk->worldSeed >> 32), (unsigned int)chunk->worldSeed, chunk->cx, chunk->cz);
+}
+
+static u32 alignOffset(u32 offset) {
+    return (offset + ISLAND_CACHE_ALIGN - 1) & ~(u32)(ISLAND_CACHE_ALIGN - 1);
+}
+
+static bool rangeInFile(u32 offset, u32 bytes, u32 fileSize) {
+    return offset % ISLAND_CACHE_ALIGN == 0 && offset <= fileSize && bytes <= fileSize - offset;
+}
+
+// The tree is used in place, so its links have to be sound: children always come after
+// their parent (kd_insert appends), which also rules out cycles
+static bool nodesValid(const KDNode* nodes, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        const KDNode* node = &nodes[i];
+        if (node->tri_count < 0 || node->tri_count > MAX_TRIANGLES) return false;
+        if (node->left != -1 && (node->left <= (int)i || (u32)node->left >= count)) return false;
+        if (node->right != -1 && (node->right <= (int)i || (u32)node->right >= count)) return false;
+    }
+    return true;
+}
+
+// Fill the chunk with islands straight out of its cache file
+// The file buffer goes into the chunk arena, islands point straight into it
+bool loadIslandCache(IslandChunk* chunk, const ChunkSettings* settings) {
+    char path[128];
+    cachePath(path, sizeof(path), chunk);
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < (long)sizeof(IslandCacheHeader)) {
+        fclose(file);
+        return false;
+    }
+
+    u8* blob = (u8*)arenaAlloc(&chunk->arena, size);
+    if (!blob) {
+        fclose(file);
+        return false;
+    }
+    bool readOk = fread(blob, 1, size, file) == (size_t)size;
+    fclose(file);
+
+    IslandCacheHeader* header = (IslandCacheHeader*)blob;
+    if (!readOk ||
+        header->magic != ISLAND_CACHE_MAGIC ||
+        header->version != ISLAND_CACHE_VERSION ||
+        header->worldSeed != chunk->worldSeed ||
+        header->chunkX != chunk->cx || header->chunkZ != chunk->cz ||
+        header->paramsHash != generationParamsHash(settings) ||
+        header->fileSize != (u32)size ||
+        header->islandCount > ISLAND_CACHE_MAX_ISLANDS ||
+        !rangeInFile(alignOffset(sizeof(IslandCacheHeader)), header->islandCount * sizeof(IslandCacheRecord), (u32)size)) {
+        arenaReset(&chunk->arena);
+        return false;
+    }
+
+    IslandCacheRecord* records = (IslandCacheRecord*)(blob + alignOffset(sizeof(IslandCacheHeader)));
+
+    // Validate every range before handing out any pointers
+    for (u32 i = 0; i < header->islandCount; i++) {
+        IslandCacheRecord* rec = &records[i];
+        u32 segments = rec->segments;
+        int expectedVertices, expectedIndices;
+        islandMeshCounts((IslandShape)rec->shape, (int)segments, &expectedVertices, &expectedIndices);
+        bool meshOk = rec->shape <= ISLAND_SHAPE_NOISE && (rec->numVertices == 0 ||
+            (rec->numVertices == (u32)expectedVertices && rec->numIndices == (u32)expectedIndices &&
+             rec->positionScale > 0.0f));
+        bool instanceOk = rec->archetype < 0 || (islandArchetype(rec->archetype) && rec->numVertices == 0 && rec->nodeCount == 0);
+        if ((int)segments != clampIslandSegments(segments) || !meshOk || !instanceOk ||
+            rec->colorStyle > ISLAND_ARCTIC ||
+            !rangeInFile(rec->vertexOffset, rec->numVertices * sizeof(IslandVertex), (u32)size) ||
+            !rangeInFile(rec->indexOffset, rec->numIndices * sizeof(u16), (u32)size) ||
+            rec->nodeCount > (u32)size / sizeof(KDNode) ||  // Before the multiply below can wrap
+            !rangeInFile(rec->nodeOffset, rec->nodeCount * sizeof(KDNode), (u32)size) ||
+            (rec->nodeCount && !rangeInFile(rec->sdfOffset, SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float), (u32)size)) ||
+            !nodesValid((const KDNode*)(blob + rec->nodeOffset), rec->nodeCount)) {
+            arenaReset(&chunk->arena);
+            return false;
+        }
+    }
+
+    chunk->islands = (Island**)arenaCalloc(&chunk->arena, (header->islandCount ? header->islandCount : 1) * sizeof(Island*));
+    if (!chunk->islands) {
+        arenaReset(&chunk->arena);
+        return false;
+    }
+
+    float centerX, centerZ;
+    chunkCenter(chunk, settings, &centerX, &centerZ);
+
+    for (u32 i = 0; i < header->islandCount; i++) {
+        IslandCacheRecord* rec = &records[i];
+        Island* island = (Island*)arenaCalloc(&chunk->arena, sizeof(Island));
+        if (!island) break;
+
+        island->position = rec->position;
+        island->radius = rec->radius;
+        island->colorStyle = (IslandType)rec->colorStyle;
+        island->seed = rec->seed;
+        island->shape = (IslandShape)rec->shape;
+        island->segments = rec->segments;
+        island->noise = rec->noise;
+        island->noiseExtent = rec->noiseExtent;
+        island->noiseHeight = rec->noiseHeight;
+        memcpy(island->ctrlRadius, rec->ctrlRadius, sizeof(island->ctrlRadius));
+        memcpy(island->ctrlHeight, rec->ctrlHeight, sizeof(island->ctrlHeight));
+        island->boundsMin = rec->boundsMin;
+        island->boundsMax = rec->boundsMax;
+        island->sdfMinX = rec->sdfMinX;
+        island->sdfMinZ = rec->sdfMinZ;
+        island->sdfCellSize = rec->sdfCellSize;
+        memcpy(island->waterMask, rec->waterMask, sizeof(island->waterMask));
+        island->waterMaskCell = rec->waterMaskCell;
+        memcpy(island->occluderSteps, rec->occluderSteps, sizeof(island->occluderSteps));
+        if (rec->archetype >= 0) {
+            island->archetypeIndex = rec->archetype;
+            island->archetype = islandArchetype(rec->archetype);
+            island->yaw = rec->yaw;
+            island->scale = rec->scale;
+            island->cosYaw = cosf(rec->yaw);
+            island->sinYaw = sinf(rec->yaw);
+        }
+        shiftIsland(island, centerX, centerZ);
+
+        // Point straight into the file buffer, no copies and no per-node allocation
+        if (rec->numVertices) {
+            island->numVertices = rec->numVertices;
+            island->vertices = (IslandVertex*)(blob + rec->vertexOffset);
+            island->positionScale = rec->positionScale;
+            island->numIndices = rec->numIndices;
+            island->indices = (u16*)(blob + rec->indexOffset);
+            island->meshFromCache = true;
+        }
+        if (rec->nodeCount) {
+            island->shoreSdf = (float*)(blob + rec->sdfOffset);
+            island->kdTree.nodes = (KDNode*)(blob + rec->nodeOffset);
+            island->kdTree.count = rec->nodeCount;
+            island->kdTree.capacity = rec->nodeCount;
+            island->kdTree.ownsNodes = 0;
+            island->collisionFromCache = true;
+        }
+
+        island->isInitialized = true;
+        chunk->islands[chunk->count++] = island;
+    }
+
+    return true;
+}
+
+bool saveIslandCache(const IslandChunk* chunk, const ChunkSettings* settings) {
+    // Lay out the file first so it can be written in one go
+    u32 recordsOffset = alignOffset(sizeof(IslandCacheHeader));
+    u32 offset = alignOffset(recordsOffset + chunk->count * sizeof(IslandCacheRecord));
+    for (int i = 0; i < chunk->count; i++) {
+        Island* island = chunk->islands[i];
+        offset = alignOffset(offset + island->numVertices * sizeof(IslandVertex));
+        offset = alignOffset(offset + island->numIndices * sizeof(u16));
+        offset = alignOffset(offset + island->kdTree.count * sizeof(KDNode));
+        if (island->kdTree.count) offset = alignOffset(offset + SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float));
+    }
+    u32 fileSize = offset;
+
+    u8* blob = (u8*)memalign(ISLAND_CACHE_ALIGN, fileSize);
+    if (!blob) return false;
+    memset(blob, 0, fileSize);
+
+    IslandCacheHeader* header = (IslandCacheHeader*)blob;
+    header->magic = ISLAND_CACHE_MAGIC;
+    header->version = ISLAND_CACHE_VERSION;
+    header->worldSeed = chunk->worldSeed;
+    header->chunkX = chunk->cx;
+    header->chunkZ = chunk->cz;
+    header->paramsHash = generationParamsHash(settings);
+    header->islandCount = chunk->count;
+    header->fileSize = fileSize;
+
+    IslandCacheRecord* records = (IslandCacheRecord*)(blob + recordsOffset);
+    offset = alignOffset(recordsOffset + chunk->count * sizeof(IslandCacheRecord));
+    float centerX, centerZ;
+    chunkCenter(chunk, settings, &centerX, &centerZ);
+
+    for (int i = 0; i < chunk->count; i++) {
+        Island* island = chunk->islands[i];
+        IslandCacheRecord* rec = &records[i];
+
+        Island centered = *island;
+        shiftIsland(&centered, -centerX, -centerZ);
+
+        rec->position = centered.position;
+        rec->radius = island->radius;
+        rec->colorStyle = island->colorStyle;
+        rec->seed = island->seed;
+        rec->shape = island->shape;
+        rec->segments = island->segments;
+        rec->noise = island->noise;
+        rec->noiseExtent = island->noiseExtent;
+        rec->noiseHeight = island->noiseHeight;
+        memcpy(rec->ctrlRadius, island->ctrlRadius, sizeof(rec->ctrlRadius));
+        memcpy(rec->ctrlHeight, island->ctrlHeight, sizeof(rec->ctrlHeight));
+        rec->boundsMin = centered.boundsMin;
+        rec->boundsMax = centered.boundsMax;
+        rec->sdfMinX = centered.sdfMinX;
+        rec->sdfMinZ = centered.sdfMinZ;
+        rec->sdfCellSize = island->sdfCellSize;
+        memcpy(rec->waterMask, island->waterMask, sizeof(rec->waterMask));
+        rec->waterMaskCell = island->waterMaskCell;
+        memcpy(rec->occluderSteps, island->occluderSteps, sizeof(rec->occluderSteps));
+        rec->archetype = island->archetype ? island->archetypeIndex : -1;
+        rec->yaw = island->yaw;
+        rec->scale = island->scale;
+
+        if (island->vertices) {
+            rec->positionScale = island->positionScale;
+            rec->numVertices = island->numVertices;
+            rec->vertexOffset = offset;
+            memcpy(blob + offset, island->vertices, island->numVertices * sizeof(IslandVertex));
+            offset = alignOffset(offset + island->numVertices * sizeof(IslandVertex));
+
+            rec->numIndices = island->numIndices;
+            rec->indexOffset = offset;
+            memcpy(blob + offset, island->indices, island->numIndices * sizeof(u16));
+            offset = alignOffset(offset + island->numIndices * sizeof(u16));
+        }
+
+        if (island->kdTree.nodes) {
+            rec->nodeCount = island->kdTree.count;
+            rec->nodeOffset = offset;
+            memcpy(blob + offset, island->kdTree.nodes, island->kdTree.count * sizeof(KDNode));
+            offset = alignOffset(offset + island->kdTree.count * sizeof(KDNode));
+
+            rec->sdfOffset = offset;
+            memcpy(blob + offset, island->shoreSdf, SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float));
+            offset = alignOffset(offset + SHORE_SDF_RES * SHORE_SDF_RES * sizeof(float));
+        }
+    }
+
+    // Write to a temp file and rename, so a half-written cache is never picked up
+    char path[128], tempPath[136];
+    cachePath(path, sizeof(path), chunk);
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    mkdir(ISLAND_CACHE_DIR, 0777);
+
+    bool ok = false;
+    FILE* file = fopen(tempPath, "wb");
+    if (file) {
+        ok = fwrite(blob, 1, fileSize, file) == fileSize;
+        ok = (fclose(file) == 0) && ok;
+        if (ok) {
+            remove(path);
+            ok = rename(tempPath, path) == 0;
+        }
+        else {
+            remove(tempPath);
+        }
+    }
+
+    free(blob);
+    return ok;
+}
@@ -0,0 +1,16 @@
+#ifndef ISLAND_CACHE_H
+#define ISLAND_CACHE_H
+
+#include "chunks.h"
+
+// On-disk island cache, one file per world seed and chunk
+#define ISLAND_CACHE_DIR      "sd:/island_game"
+#define ISLAND_CACHE_MAGIC    0x49534C43  // "ISLC"
+#define ISLAND_CACHE_VERSION  12
+#define ISLAND_CACHE_ALIGN    32
+#define ISLAND_CACHE_MAX_ISLANDS  256  // Sanity limit for a chunk file
+
+bool loadIslandCache(IslandChunk* chunk, const ChunkSettings* settings);
+bool saveIslandCache(const IslandChunk* chunk, const ChunkSettings* settings);
+
+#endif
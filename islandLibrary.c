@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <string.h>
+#include "islandLibrary.h"
+#include "rng.h"
+#include "workers.h"
+
+static Island archetypes[ISLAND_LIBRARY_SIZE];
+static bool archetypeReady[ISLAND_LIBRARY_SIZE];
+
+static void buildArchetypeJob(void* context, int index) {
+    Island* island = &archetypes[index];
+    archetypeReady[index] = ensureIslandMesh(island) && ensureIslandCollision(island) && ensureIslandProps(island);
+}
+
+// Archetypes are generated like chunk islands, but centered on the origin and with
+// the color styles taken in turn so each style gets its share
+void initIslandLibrary() {
+    memset(archetypes, 0, sizeof(archetypes));
+    memset(archetypeReady, 0, sizeof(archetypeReady));
+
+    for (int i = 0; i < ISLAND_LIBRARY_SIZE; i++) {
+        Island* island = &archetypes[i];
+        island->seed = rngDeriveSeed(ISLAND_LIBRARY_SEED, (u32)i);
+
+        Rng generatorRng;
+        rngSeed(&generatorRng, island->seed, RNG_STREAM_GENERATOR);
+        if (rngRange(&generatorRng, 100) < ISLAND_NOISE_PERCENT) {
+            island->shape = ISLAND_SHAPE_NOISE;
+            island->segments = ISLAND_HEIGHTMAP_RES;
+        } else {
+            island->shape = ISLAND_SHAPE_POLAR;
+            island->segments = NUM_SEGMENTS;
+        }
+        generateIslandParams(island);
+        island->colorStyle = (IslandType)(i % 3);
+        island->position.y = -2.0f;
+        finishIslandParams(island);
+    }
+
+    workerParallelFor(buildArchetypeJob, NULL, ISLAND_LIBRARY_SIZE);
+}
+
+void shutdownIslandLibrary() {
+    for (int i = 0; i < ISLAND_LIBRARY_SIZE; i++) {
+        freeIslandResources(&archetypes[i]);
+        archetypeReady[i] = false;
+    }
+}
+
+Island* islandArchetype(int index) {
+    if (index < 0 || index >= ISLAND_LIBRARY_SIZE || !archetypeReady[index]) return NULL;
+    return &archetypes[index];
+}
+
+void islandLibraryStats(ArenaStats* stats) {
+    for (int i = 0; i < ISLAND_LIBRARY_SIZE; i++) {
+        arenaAddStats(&archetypes[i].meshArena, stats);
+        arenaAddStats(&archetypes[i].collisionArena, stats);
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef ISLAND_LIBRARY_H
+#define ISLAND_LIBRARY_H
+
+#include "island.h"
+
+// Small set of fully built islands that instanced islands reuse, so their memory
+// grows with the library instead of the island count
+#define ISLAND_LIBRARY_SIZE       12                     // Archetypes, spread over the color styles
+#define ISLAND_LIBRARY_SEED       0x5EEDB0A7151A4D5Full  // Same archetypes in every world
+#define ISLAND_INSTANCED_PERCENT  75                     // Share of islands placed as instances
+
+// Builds every archetype up front (on the worker pool), after initArenaPool and initWorkerPool
+void initIslandLibrary();
+void shutdownIslandLibrary();
+
+// NULL when the index is out of range or the archetype failed to build
+Island* islandArchetype(int index);
+void islandLibraryStats(ArenaStats* stats);
+
+#endif
@@ -17,35 +17,79 @@ static Vec3 triangle_center(const Triangle* t) {
     };
 }
 
-// Insert a triangle into the KD-tree at a given depth (depth is used to determine splitting axis)
-KDNode* kd_insert(KDNode* root, Triangle tri, int depth) {
-    int axis = depth % 3;  // Cycles through 0 (x), 1 (y), 2 (z)
-    Vec3 center = triangle_center(&tri);  // Compute center of triangle
-    float value = get_axis_value(center, axis);  // Get coordinate on the chosen axis
-
-    if (!root) {
-        // Create a new node if current root is NULL
-        KDNode* node = (KDNode*)calloc(1, sizeof(KDNode));
-        node->axis = axis;   // Store splitting axis
-        node->split = value; // Store splitting value (used to decide left/right in future)
-        node->triangles[0] = tri;  // Store triangle in this node
-        node->tri_count = 1;
-        return node;
+// Grow a node's bounds to contain a triangle
+static void grow_bounds(KDNode* node, const Triangle* t) {
+    const Vec3* verts[3] = { &t->v1, &t->v2, &t->v3 };
+    for (int i = 0; i < 3; i++) {
+        node->min.x = fminf(node->min.x, verts[i]->x);
+        node->min.y = fminf(node->min.y, verts[i]->y);
+        node->min.z = fminf(node->min.z, verts[i]->z);
+        node->max.x = fmaxf(node->max.x, verts[i]->x);
+        node->max.y = fmaxf(node->max.y, verts[i]->y);
+        node->max.z = fmaxf(node->max.z, verts[i]->z);
     }
+}
+
+// Reserve room for a tree of up to maxTriangles triangles (every node holds at least one)
+void kd_init(KDTree* tree, int maxTriangles) {
+    tree->nodes = (KDNode*)malloc(maxTriangles * sizeof(KDNode));
+    tree->count = 0;
+    tree->capacity = tree->nodes ? maxTriangles : 0;
+    tree->ownsNodes = 1;
+}
+
+// Insert a triangle, walking down from the root (depth decides the splitting axis)
+void kd_insert(KDTree* tree, Triangle tri) {
+    Vec3 center = triangle_center(&tri);  // Compute center of triangle
+    int* link = NULL;  // Child slot of the parent that points at the current node
+    int index = tree->count > 0 ? 0 : -1;
+    int depth = 0;
+
+    while (index != -1) {
+        KDNode* node = &tree->nodes[index];
+
+        // Every node on the insertion path has to cover the new triangle
+        grow_bounds(node, &tri);
 
-    if (root->tri_count < MAX_TRIANGLES) {
-        // If this node has space, just store the triangle here
-        root->triangles[root->tri_count++] = tri;
-        return root;
+        if (node->tri_count < MAX_TRIANGLES) {
+            // If this node has space, just store the triangle here
+            node->triangles[node->tri_count++] = tri;
+            return;
+        }
+
+        // Otherwise, pass triangle to either left or right subtree based on its center's position
+        link = get_axis_value(center, node->axis) < node->split ? &node->left : &node->right;
+        index = *link;
+        depth++;
     }
 
-    // Otherwise, pass triangle to either left or right subtree based on its center's position
-    if (value < root->split)
-        root->left = kd_insert(root->left, tri, depth + 1);
-    else
-        root->right = kd_insert(root->right, tri, depth + 1);
+    if (tree->count >= tree->capacity) return;
 
-    return root;
+    // Create a new node at the end of the array
+    int axis = depth % 3;  // Cycles through 0 (x), 1 (y), 2 (z)
+    KDNode* node = &tree->nodes[tree->count];
+    node->axis = axis;   // Store splitting axis
+    node->split = get_axis_value(center, axis); // Store splitting value (used to decide left/right in future)
+    node->triangles[0] = tri;  // Store triangle in this node
+    node->tri_count = 1;
+    node->left = -1;
+    node->right = -1;
+    node->min = node->max = tri.v1;
+    grow_bounds(node, &tri);
+
+    if (link) *link = tree->count;
+    tree->count++;
+}
+
+// Give back the unused part of the node array once building is done
+void kd_finish(KDTree* tree) {
+    if (!tree->ownsNodes || tree->count == tree->capacity || tree->count == 0) return;
+
+    KDNode* shrunk = (KDNode*)realloc(tree->nodes, tree->count * sizeof(KDNode));
+    if (shrunk) {
+        tree->nodes = shrunk;
+        tree->capacity = tree->count;
+    }
 }
 
 // Helper to compute squared distance between two points (avoids slow sqrt for distance)
@@ -56,8 +100,8 @@ static float point_distance_squared(Vec3 a, Vec3 b) {
 
 // The distance from the query point to the splitting plane is less than the distance to your current farthest nearest neighbor.
 // Query the KD-tree for all triangles within a given radius of a point
-void kd_query_nearest(const KDNode* root, Vec3 point, int numTriangles, void (*callback)(const Triangle*)) {
-    if (!root || numTriangles <= 0) return;
+void kd_query_nearest(const KDTree* tree, Vec3 point, int numTriangles, void (*callback)(const Triangle*)) {
+    if (!tree || tree->count == 0 || numTriangles <= 0) return;
 
     // Structs to hold results and their distances
     const Triangle* closest[numTriangles];
@@ -71,8 +115,9 @@ void kd_query_nearest(const KDNode* root, Vec3 point, int numTriangles, void (*c
     }
 
     // Recursive traversal
-    void search(const KDNode * node) {
-        if (!node) return;
+    void search(int index) {
+        if (index == -1) return;
+        const KDNode* node = &tree->nodes[index];
 
         // Check all triangles in this node
         for (int i = 0; i < node->tri_count; i++) {
@@ -104,8 +149,8 @@ void kd_query_nearest(const KDNode* root, Vec3 point, int numTriangles, void (*c
         float axisVal = get_axis_value(point, node->axis);
         float diff = axisVal - node->split;
         float planeDistSq = diff * diff;
-        KDNode* first = axisVal < node->split ? node->left : node->right;
-        KDNode* second = axisVal < node->split ? node->right : node->left;
+        int first = axisVal < node->split ? node->left : node->right;
+        int second = axisVal < node->split ? node->right : node->left;
 
         // Always search near side
         search(first);
@@ -117,7 +162,7 @@ void kd_query_nearest(const KDNode* root, Vec3 point, int numTriangles, void (*c
     }
 
     // Start recursive search
-    search(root);
+    search(0);
 
     // Return closest triangles via callback
     for (int i = 0; i < count; i++) {
@@ -126,10 +171,79 @@ void kd_query_nearest(const KDNode* root, Vec3 point, int numTriangles, void (*c
 }
 
 
-// Recursively free all nodes in the KD-tree
-void kd_free(KDNode* root) {
-    if (!root) return;
-    kd_free(root->left);   // Free left subtree
-    kd_free(root->right);  // Free right subtree
-    free(root);            // Free current node
+// Ray-triangle intersection (Moller-Trumbore), returns hit distance or -1
+static float ray_triangle_distance(Vec3 orig, Vec3 dir, const Triangle* tri) {
+    const float EPSILON = 1e-6f;
+    Vec3 e1 = { tri->v2.x - tri->v1.x, tri->v2.y - tri->v1.y, tri->v2.z - tri->v1.z };
+    Vec3 e2 = { tri->v3.x - tri->v1.x, tri->v3.y - tri->v1.y, tri->v3.z - tri->v1.z };
+    Vec3 p = { dir.y * e2.z - dir.z * e2.y, dir.z * e2.x - dir.x * e2.z, dir.x * e2.y - dir.y * e2.x };
+    float det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+    if (fabsf(det) < EPSILON) return -1.0f;
+
+    float invDet = 1.0f / det;
+    Vec3 t = { orig.x - tri->v1.x, orig.y - tri->v1.y, orig.z - tri->v1.z };
+    float u = (t.x * p.x + t.y * p.y + t.z * p.z) * invDet;
+    if (u < 0.0f || u > 1.0f) return -1.0f;
+
+    Vec3 q = { t.y * e1.z - t.z * e1.y, t.z * e1.x - t.x * e1.z, t.x * e1.y - t.y * e1.x };
+    float v = (dir.x * q.x + dir.y * q.y + dir.z * q.z) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return -1.0f;
+
+    float dist = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * invDet;
+    return dist > EPSILON ? dist : -1.0f;
+}
+
+// Slab test: distance where the ray enters the box, or -1 if it misses before maxDist
+static float ray_box_entry(Vec3 orig, Vec3 invDir, Vec3 min, Vec3 max, float maxDist) {
+    float t0 = 0.0f, t1 = maxDist;
+    for (int axis = 0; axis < 3; axis++) {
+        float o = get_axis_value(orig, axis);
+        float inv = get_axis_value(invDir, axis);
+        float tNear = (get_axis_value(min, axis) - o) * inv;
+        float tFar = (get_axis_value(max, axis) - o) * inv;
+        if (tNear > tFar) { float tmp = tNear; tNear = tFar; tFar = tmp; }
+        if (tNear > t0) t0 = tNear;
+        if (tFar < t1) t1 = tFar;
+        if (t0 > t1) return -1.0f;
+    }
+    return t0;
+}
+
+// Closest hit along a normalized ray, pruning subtrees by their bounds
+// Returns maxDist when nothing is hit
+float kd_raycast(const KDTree* tree, Vec3 origin, Vec3 dir, float maxDist) {
+    float closest = maxDist;
+    if (!tree || tree->count == 0) return closest;
+
+    Vec3 invDir = {
+        dir.x != 0.0f ? 1.0f / dir.x : FLT_MAX,
+        dir.y != 0.0f ? 1.0f / dir.y : FLT_MAX,
+        dir.z != 0.0f ? 1.0f / dir.z : FLT_MAX
+    };
+
+    void search(int index) {
+        if (index == -1) return;
+        const KDNode* node = &tree->nodes[index];
+        if (ray_box_entry(origin, invDir, node->min, node->max, closest) < 0.0f) return;
+
+        for (int i = 0; i < node->tri_count; i++) {
+            float dist = ray_triangle_distance(origin, dir, &node->triangles[i]);
+            if (dist > 0.0f && dist < closest) closest = dist;
+        }
+
+        search(node->left);
+        search(node->right);
+    }
+
+    search(0);
+    return closest;
+}
+
+// Free the node array (all nodes live in one allocation)
+void kd_free(KDTree* tree) {
+    if (!tree) return;
+    if (tree->ownsNodes) free(tree->nodes);
+    tree->nodes = NULL;
+    tree->count = 0;
+    tree->capacity = 0;
 }
@@ -18,13 +18,28 @@ typedef struct KDNode {
     int axis; // 0 = x, 1 = y, 2 = z
     float split;
 
-    struct KDNode* left;
-    struct KDNode* right;
-} KDNode;
+    // Bounds of every triangle in this subtree (used to prune ray queries)
+    Vec3 min, max;
 
-KDNode* kd_insert(KDNode* root, Triangle tri, int depth);
-void kd_query_nearest(const KDNode* root, Vec3 point, int numTriangles, void (*callback)(const Triangle*));
+    // Children are indices into KDTree.nodes (-1 = none), so the tree can be
+    // written to disk and used in place without fixing up pointers
+    int left;
+    int right;
+} KDNode;
 
-void kd_free(KDNode* root);
+typedef struct {
+    KDNode* nodes;  // nodes[0] is the root
+    int count;
+    int capacity;
+    int ownsNodes;  // 0 when nodes point into memory owned by someone else (e.g. a cache file)
+} KDTree;
+
+void kd_init(KDTree* tree, int maxTriangles);
+void kd_insert(KDTree* tree, Triangle tri);
+void kd_finish(KDTree* tree);
+void kd_query_nearest(const KDTree* tree, Vec3 point, int numTriangles, void (*callback)(const Triangle*));
+float kd_raycast(const KDTree* tree, Vec3 origin, Vec3 dir, float maxDist);
+
+void kd_free(KDTree* tree);
 
 #endif
@@ -3,7 +3,9 @@
 #include <string.h>
 #include <malloc.h>
 #include <math.h>
+#include <time.h>
 #include <gccore.h>
+#include <fat.h>
 #include "gx_utils.h"
 #include <stdbool.h>
 #include "common.h"
@@ -14,8 +16,25 @@
 #include "manager.h"
 #include "bodyManager.h"
 #include "camera.h"
+#include "profiler.h"
+#include "rng.h"
+#include "workers.h"
+#include "snapshot.h"
+#include "arena.h"
+#include "islandLibrary.h"
 
 
+// Waves follow the world, not the floating origin
+static void syncWaveOrigin(const IslandManager* manager) {
+    setWaveOrigin((double)manager->originCx * manager->settings.chunkSize,
+        (double)manager->originCz * manager->settings.chunkSize);
+}
+
+static void printArenaStats(const char* name, const ArenaStats* stats) {
+    printf("%-20s %u arenas, %u blocks, %u KB used of %u KB\n", name, stats->arenas, stats->blocks,
+        (u32)(stats->used / 1024), (u32)(stats->reserved / 1024));
+}
+
 int main(int argc, char** argv) {
     // Original main function code exactly as you wrote it
     f32 yscale;
@@ -30,14 +49,52 @@ int main(int argc, char** argv) {
     VIDEO_Init();
     PAD_Init();
 
+    // SD card for the island cache; without it the world is just generated every time
+    fatInitDefault();
+
+    // printf goes to the USB Gecko / Dolphin log, where the stats readout shows up
+    SYS_STDIO_Report(true);
+
     IslandManager islandManager;
     BodyManager bodyManager;
+    static OcclusionBuffer occlusion;  // 12 KB, rebuilt every frame
+
+    // The whole world is derived from this seed (read before 'time' shadows time())
+    u64 worldSeed = (u64)time(NULL);
+
+    // Boat, player and camera setup
+    Boat boat;
+    Player player;
+    Camera camera;
+    initBoat(&boat);
+    initPlayer(&player);
+    initCamera(&camera);
+
+    bool isPlayerActive = false; // Start with boat active
 
-    initIslandManager(&islandManager);
-    regenerateIslands(&islandManager);
+    // Time variable for animation
+    f32 time = 0.0f;
 
+    initArenaPool();
+    initPropArchetypes();
+    initWorkerPool();
+    initIslandLibrary();
+    initWorldBuilder();
     initBodyManager(&bodyManager);
-    spawnBodiesOnIslands(&bodyManager, &islandManager);
+
+    // Resume the last session if there is one, otherwise start a fresh world
+    if (loadSnapshot(&islandManager, &bodyManager, &boat, &player, &camera, &isPlayerActive, &time)) {
+        worldSeed = islandManager.worldSeed;
+    }
+    else {
+        Vec3 boatPos = { boat.position.x, boat.position.y, boat.position.z };
+        initIslandManager(&islandManager, worldSeed);
+        regenerateIslands(&islandManager, boatPos);
+        profileAddTicks(PROF_ISLAND_GENERATION, islandManager.generationTicks);
+
+        spawnBodiesOnIslands(&bodyManager, &islandManager);
+    }
+    syncWaveOrigin(&islandManager);
 
     rmode = VIDEO_GetPreferredMode(NULL);
 
@@ -81,23 +138,15 @@ int main(int argc, char** argv) {
 
     // Setup the vertex attribute table
     GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS, GX_POS_XYZ, GX_F32, 0);
-    GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGB8, 0);
+    GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGB, GX_RGB8, 0);
+    setupIslandVertexFormat();
+    initWater();
 
     GX_SetNumChans(1);
     GX_SetNumTexGens(0);
     GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORDNULL, GX_TEXMAP_NULL, GX_COLOR0A0);
     GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
 
-    // Boat, player and camera setup
-    Boat boat;
-    Player player;
-    Camera camera;
-    initBoat(&boat);
-    initPlayer(&player);
-    initCamera(&camera);
-
-    bool isPlayerActive = false; // Start with boat active
-
     // Setup the initial view matrix
     guLookAt(view, &camera.position, &camera.up, &camera.look);
 
@@ -107,18 +156,66 @@ int main(int argc, char** argv) {
     guPerspective(perspective, 45, (f32)w / h, 0.1F, 100.0F);  // Adjust far clipping distance
     GX_LoadProjectionMtx(perspective, GX_PERSPECTIVE);
 
-    // Time variable for animation
-    f32 time = 0.0f;
-
     // Main game loop
     while (1) {
+        profilerBeginFrame();
+
+        // Frame boundary: pick up a world finished in the background
+        if (swapRegeneratedIslands(&islandManager)) {
+            camera.cacheValid = false;
+        }
+
+        // Let go of island meshes and collision nobody has used in a while
+        trimIslandMemory(&islandManager);
+
+        // Keep the ocean chunks around whoever is being controlled loaded
+        guVector* focusPos = isPlayerActive ? &player.position : &boat.position;
+        Vec3 focus = { focusPos->x, focusPos->y, focusPos->z };
+
+        // Far from the origin: move it, and everything in local space along with it
+        float shiftX, shiftZ;
+        if (rebaseIslandOrigin(&islandManager, focus, &shiftX, &shiftZ)) {
+            boat.position.x += shiftX;
+            boat.position.z += shiftZ;
+            player.position.x += shiftX;
+            player.position.z += shiftZ;
+            shiftBodies(&bodyManager, shiftX, shiftZ);
+            shiftCamera(&camera, shiftX, shiftZ);
+            focus.x += shiftX;
+            focus.z += shiftZ;
+            syncWaveOrigin(&islandManager);
+        }
+        streamIslandChunks(&islandManager, focus);
+
         PAD_ScanPads();
 
-        if (PAD_ButtonsDown(0) & PAD_BUTTON_START) exit(0);
+        // Start saves the session and quits, Z just saves
+        if (PAD_ButtonsDown(0) & (PAD_BUTTON_START | PAD_TRIGGER_Z)) {
+            saveSnapshot(&islandManager, &bodyManager, &boat, &player, &camera, isPlayerActive, time);
+            if (PAD_ButtonsDown(0) & PAD_BUTTON_START) exit(0);
+        }
+
+        // D-pad up prints the last frame's numbers and where island memory is going
+        if (PAD_ButtonsDown(0) & PAD_BUTTON_UP) {
+            printf("--- frame stats ---\n");
+            printFrameProfile(&lastFrameProfile);
+
+            ArenaStats chunkStats, stageStats, libraryStats = { 0 };
+            ArenaPoolStats poolStats;
+            islandMemoryStats(&islandManager, &chunkStats, &stageStats);
+            islandLibraryStats(&libraryStats);  // Adds to what it's given
+            arenaPoolStats(&poolStats);
+            printArenaStats("chunk arenas", &chunkStats);
+            printArenaStats("island stages", &stageStats);
+            printArenaStats("island library", &libraryStats);
+            printf("%-20s %u free, %u made, %u reused\n", "arena pool",
+                poolStats.freeBlocks, poolStats.blocksMade, poolStats.blocksReused);
+        }
 
-        // Add this block to handle A button press
+        // A builds a new world in the background, it swaps in once ready
         if (PAD_ButtonsDown(0) & PAD_BUTTON_A) {
-            regenerateIslands(&islandManager);
+            worldSeed = rngMix(worldSeed);
+            requestIslandRegeneration(worldSeed, focus, islandManager.originCx, islandManager.originCz);
         }
 
         // Handle B button press (switch between boat and player)
@@ -128,12 +225,11 @@ int main(int argc, char** argv) {
             if (!isPlayerActive) {
                 Vec3 boatPos = {
                     boat.position.x,
-                    sinf((boat.position.x + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE +
-                    cosf((boat.position.z + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE,
+                    waveHeightAt(boat.position.x, boat.position.z, time),
                     boat.position.z
                 };
 
-                if (checkAllIslandsCollision(&islandManager, boatPos, boat.radius)) {
+                if (shoreDistance(&islandManager, boatPos, NULL) < boat.radius) {
                     // Boat is on land, allow switching to player
                     isPlayerActive = true;
                     player.position = boat.position;
@@ -192,7 +288,15 @@ int main(int argc, char** argv) {
         guMtxConcat(view, model, modelview);
         GX_LoadPosMtxImm(modelview, GX_PNMTX0);
 
-        drawWater(time);
+        // Culling planes for this frame, in the space everything below is drawn in
+        Frustum frustum;
+        frustumFromCamera(&frustum, perspective, modelview);
+
+        // Nearby islands hide what's behind them from the islands, bodies and props drawn below
+        Vec3 viewPos = { camera.position.x, camera.position.y, camera.position.z };
+        buildIslandOcclusion(&islandManager, &occlusion, perspective, modelview, viewPos);
+
+        drawWater(time, camera.position.x, camera.position.z, modelview, &frustum, &islandManager);
 
         // Increment time for wave movement
         time += WAVE_SPEED;
@@ -211,14 +315,13 @@ int main(int argc, char** argv) {
             updateBodies(&bodyManager, &islandManager, playerPos);
         }
         else {
-            float boatHeight = sinf((boat.position.x + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE +
-                cosf((boat.position.z + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE;
+            float boatHeight = waveHeightAt(boat.position.x, boat.position.z, time);
             drawBoat(boat.position.x, boatHeight, boat.position.z, boat.yaw);
         }
 
         
-        drawAllIslands(&islandManager);
-        drawBodies(&bodyManager);
+        drawAllIslands(&islandManager, viewPos, modelview, &frustum, &occlusion);
+        drawBodies(&bodyManager, &frustum, &occlusion);
 
         // Finalize drawing
         GX_DrawDone();
@@ -234,6 +337,11 @@ int main(int argc, char** argv) {
         VIDEO_WaitVSync();
     }
 
+    shutdownWorldBuilder();
     freeAllIslands(&islandManager);
+    shutdownIslandLibrary();
+    shutdownWater();
+    shutdownWorkerPool();
+    shutdownArenaPool();
     return 0;
 }
\ No newline at end of file
@@ -1,101 +1,458 @@
 #include "manager.h"
+#include "rng.h"
+#include "workers.h"
+#include "profiler.h"
+#include "islandCache.h"
+#include "placement.h"
 #include <stdlib.h>
-#include <time.h>
 #include <string.h>
+#include <float.h>
+#include <math.h>
+#include <malloc.h>
 
-void initIslandManager(IslandManager* manager) {
+static int gridCoord(float v) {
+    return (int)floorf(v / ISLAND_GRID_CELL);
+}
+
+static int gridBucket(int cellX, int cellZ) {
+    unsigned int h = ((unsigned int)cellX * 73856093u) ^ ((unsigned int)cellZ * 19349663u);
+    return (int)(h % ISLAND_GRID_BUCKETS);
+}
+
+static void clearIslandGrid(IslandManager* manager) {
+    for (int i = 0; i < ISLAND_GRID_BUCKETS; i++) {
+        manager->gridHeads[i] = -1;
+    }
+    manager->gridEntryCount = 0;
+}
+
+// Register the island in every grid cell its bounds overlap
+static void gridInsertIsland(IslandManager* manager, int index) {
+    Island* island = manager->islands[index];
+
+    int minX = gridCoord(island->boundsMin.x), maxX = gridCoord(island->boundsMax.x);
+    int minZ = gridCoord(island->boundsMin.z), maxZ = gridCoord(island->boundsMax.z);
+
+    for (int cz = minZ; cz <= maxZ; cz++) {
+        for (int cx = minX; cx <= maxX; cx++) {
+            if (manager->gridEntryCount >= manager->gridEntryCapacity) {
+                int newCapacity = manager->gridEntryCapacity ? manager->gridEntryCapacity * 2 : 64;
+                IslandGridEntry* grown = (IslandGridEntry*)realloc(manager->gridEntries, newCapacity * sizeof(IslandGridEntry));
+                if (!grown) return;
+                manager->gridEntries = grown;
+                manager->gridEntryCapacity = newCapacity;
+            }
+
+            int bucket = gridBucket(cx, cz);
+            IslandGridEntry* entry = &manager->gridEntries[manager->gridEntryCount];
+            entry->cellX = cx;
+            entry->cellZ = cz;
+            entry->island = index;
+            entry->next = manager->gridHeads[bucket];
+            manager->gridHeads[bucket] = manager->gridEntryCount++;
+        }
+    }
+}
+
+// Broad phase: collect islands whose bounds overlap the XZ box [minX, maxX] x [minZ, maxZ]
+static int gatherIslands(IslandManager* manager, float minX, float minZ, float maxX, float maxZ, Island** out) {
+    int found = 0;
+    unsigned int stamp = ++manager->queryStamp;
+
+    int cellMinX = gridCoord(minX), cellMaxX = gridCoord(maxX);
+    int cellMinZ = gridCoord(minZ), cellMaxZ = gridCoord(maxZ);
+
+    for (int cz = cellMinZ; cz <= cellMaxZ; cz++) {
+        for (int cx = cellMinX; cx <= cellMaxX; cx++) {
+            for (int e = manager->gridHeads[gridBucket(cx, cz)]; e != -1; e = manager->gridEntries[e].next) {
+                IslandGridEntry* entry = &manager->gridEntries[e];
+                if (entry->cellX != cx || entry->cellZ != cz) continue;  // Hash collision
+
+                Island* island = manager->islands[entry->island];
+                if (island->queryStamp == stamp) continue;  // Already reported through another cell
+                island->queryStamp = stamp;
+
+                if (island->boundsMax.x < minX || island->boundsMin.x > maxX ||
+                    island->boundsMax.z < minZ || island->boundsMin.z > maxZ) continue;
+
+                island->lastUsedFrame = manager->frame;
+                out[found++] = island;
+                if (found >= MAX_QUERY_ISLANDS) return found;
+            }
+        }
+    }
+    return found;
+}
+
+void initIslandManager(IslandManager* manager, u64 worldSeed) {
     manager->count = 0;
-    memset(manager->islands, 0, sizeof(Island*) * MAX_ISLANDS);
-    srand(time(NULL));
+    manager->islands = NULL;
+    manager->capacity = 0;
+    manager->chunkCount = 0;
+    defaultChunkSettings(&manager->settings);
+    manager->hasFocus = false;
+    manager->originCx = 0;
+    manager->originCz = 0;
+    manager->gridEntries = NULL;
+    manager->gridEntryCapacity = 0;
+    manager->queryStamp = 0;
+    manager->frame = 0;
+    manager->worldSeed = worldSeed;
+    manager->generationTicks = 0;
+    clearIslandGrid(manager);
 }
 
-// Generate random float between min and max
-static float randomFloatMan(float min, float max) {
-    return min + (max - min) * ((float)rand() / RAND_MAX);
+// Add an island at the end of the resident list, growing it as needed
+static bool appendIsland(IslandManager* manager, Island* island) {
+    if (manager->count >= manager->capacity) {
+        int newCapacity = manager->capacity ? manager->capacity * 2 : 16;
+        Island** grown = (Island**)realloc(manager->islands, newCapacity * sizeof(Island*));
+        if (!grown) return false;
+        manager->islands = grown;
+        manager->capacity = newCapacity;
+    }
+
+    manager->islands[manager->count++] = island;
+    return true;
+}
+
+typedef struct {
+    Island** islands;
+    int count;
+} PrebuildList;
+
+static void prebuildIslandJob(void* context, int index) {
+    PrebuildList* list = (PrebuildList*)context;
+    ensureIslandMesh(list->islands[index]);
+    ensureIslandCollision(list->islands[index]);
+    ensureIslandProps(list->islands[index]);
+}
+
+// XZ distance from a point to the island bounds, 0 inside them
+static float boundsDistance(const Island* island, Vec3 p) {
+    float dx = fmaxf(fmaxf(island->boundsMin.x - p.x, 0.0f), p.x - island->boundsMax.x);
+    float dz = fmaxf(fmaxf(island->boundsMin.z - p.z, 0.0f), p.z - island->boundsMax.z);
+    return sqrtf(dx * dx + dz * dz);
+}
+
+// Build meshes and collision for the given islands within range of focus, in parallel on
+// the main thread and one after another on the world builder (see workerParallelFor)
+static void prebuildIslands(Island** islands, int count, Vec3 focus, float range) {
+    PrebuildList list;
+    list.count = 0;
+    list.islands = (Island**)malloc((count ? count : 1) * sizeof(Island*));
+    if (!list.islands) return;
+
+    for (int i = 0; i < count; i++) {
+        Island* island = islands[i];
+        if (island && island->isInitialized && boundsDistance(island, focus) <= range) {
+            list.islands[list.count++] = island;
+        }
+    }
+    workerParallelFor(prebuildIslandJob, &list, list.count);
+    free(list.islands);
+}
+
+// Used before a world goes live so the first frames don't stall on it
+void prebuildIslandsNear(IslandManager* manager, Vec3 focus, float range) {
+    prebuildIslands(manager->islands, manager->count, focus, range);
 }
 
-void regenerateIslands(IslandManager* manager) {
-    // First properly free all existing islands
+// Once per frame: drop the built data of idle islands while over ISLAND_MEMORY_BUDGET,
+// least recently used first. Anything dropped is rebuilt on its next use
+void trimIslandMemory(IslandManager* manager) {
+    unsigned int frame = ++manager->frame;
+
+    size_t total = 0;
     for (int i = 0; i < manager->count; i++) {
-        if (manager->islands[i]) {
-            freeIslandResources(manager->islands[i]);
-            free(manager->islands[i]);
-            manager->islands[i] = NULL;
+        if (manager->islands[i]) total += islandHeavyBytes(manager->islands[i]);
+    }
+
+    while (total > ISLAND_MEMORY_BUDGET) {
+        Island* oldest = NULL;
+        for (int i = 0; i < manager->count; i++) {
+            Island* island = manager->islands[i];
+            if (!island || frame - island->lastUsedFrame < ISLAND_IDLE_FRAMES) continue;
+            if (islandHeavyBytes(island) == 0) continue;  // Nothing to free (lazy or cache-backed)
+            if (!oldest || island->lastUsedFrame < oldest->lastUsedFrame) oldest = island;
         }
+        if (!oldest) break;
+
+        total -= islandHeavyBytes(oldest);
+        releaseIslandHeavyData(oldest);
     }
+}
+
+// Chunk coordinate of a local position
+static void localChunk(const IslandManager* manager, Vec3 p, int* cx, int* cz) {
+    *cx = manager->originCx + chunkCoord(&manager->settings, p.x);
+    *cz = manager->originCz + chunkCoord(&manager->settings, p.z);
+}
+
+static int findChunk(const IslandManager* manager, int cx, int cz) {
+    for (int i = 0; i < manager->chunkCount; i++) {
+        if (manager->chunks[i]->cx == cx && manager->chunks[i]->cz == cz) return i;
+    }
+    return -1;
+}
+
+// Rebuild the resident island list and the broad phase from the chunk set
+static void rebuildResidentIslands(IslandManager* manager) {
     manager->count = 0;
+    clearIslandGrid(manager);
 
-    float newRadius = randomFloatMan(ISLAND_MIN_RADIUS, ISLAND_MAX_RADIUS);
-
-    // Create new islands at random positions with minimum distance
-    for (int i = 0; i < numIslands; i++) {
-        float x, z;
-        bool validPosition;
-        int attempts = 0;
-
-        do {
-            validPosition = true;
-            x = (rand() % 60) - 30.0f;
-            z = (rand() % 60) - 30.0f;
-
-            // Check minimum distance from other islands
-            for (int j = 0; j < manager->count; j++) {
-                float dx = x - manager->islands[j]->position.x;
-                float dz = z - manager->islands[j]->position.z;
-                float distSq = dx * dx + dz * dz;
-                if (distSq < (newRadius * 4) * (newRadius * 4)) {
-                    validPosition = false;
-                    break;
-                }
+    for (int c = 0; c < manager->chunkCount; c++) {
+        IslandChunk* chunk = manager->chunks[c];
+        for (int i = 0; i < chunk->count; i++) {
+            if (!appendIsland(manager, chunk->islands[i])) return;
+            gridInsertIsland(manager, manager->count - 1);
+        }
+    }
+}
+
+static void evictChunk(IslandManager* manager, int index) {
+    freeIslandChunk(manager->chunks[index]);
+    manager->chunks[index] = manager->chunks[--manager->chunkCount];
+    rebuildResidentIslands(manager);
+}
+
+// Least recently used chunk that isn't in use this frame, -1 if there is none
+static int leastRecentlyUsedChunk(const IslandManager* manager) {
+    int oldest = -1;
+    for (int i = 0; i < manager->chunkCount; i++) {
+        const IslandChunk* chunk = manager->chunks[i];
+        if (chunk->lastUsedFrame == manager->frame) continue;
+        if (oldest == -1 || chunk->lastUsedFrame < manager->chunks[oldest]->lastUsedFrame) oldest = i;
+    }
+    return oldest;
+}
+
+// Make a loaded chunk resident; its islands go at the end of the list
+static bool adoptChunk(IslandManager* manager, IslandChunk* chunk) {
+    if (manager->chunkCount >= MAX_RESIDENT_CHUNKS) {
+        int victim = leastRecentlyUsedChunk(manager);
+        if (victim == -1) return false;
+        evictChunk(manager, victim);
+    }
+
+    rebaseIslandChunk(chunk, &manager->settings, manager->originCx, manager->originCz);
+    chunk->lastUsedFrame = manager->frame;
+    manager->chunks[manager->chunkCount++] = chunk;
+    for (int i = 0; i < chunk->count; i++) {
+        // Fresh from the builder: not the oldest thing around just because nothing drew it yet
+        chunk->islands[i]->lastUsedFrame = manager->frame;
+        if (!appendIsland(manager, chunk->islands[i])) break;
+        gridInsertIsland(manager, manager->count - 1);
+    }
+    return true;
+}
+
+// Free every chunk and island but keep the grid storage for reuse
+static void releaseIslands(IslandManager* manager) {
+    for (int i = 0; i < manager->chunkCount; i++) {
+        freeIslandChunk(manager->chunks[i]);
+        manager->chunks[i] = NULL;
+    }
+    manager->chunkCount = 0;
+    manager->count = 0;
+    manager->hasFocus = false;
+    clearIslandGrid(manager);
+}
+
+// Loads the chunks around focus and builds meshes and collision for the islands
+// close to it; everything further out streams in later
+void regenerateIslands(IslandManager* manager, Vec3 focus) {
+    u64 start = profileStart();
+    releaseIslands(manager);
+
+    int fcx, fcz;
+    localChunk(manager, focus, &fcx, &fcz);
+    for (int dz = -CHUNK_LOAD_RADIUS; dz <= CHUNK_LOAD_RADIUS; dz++) {
+        for (int dx = -CHUNK_LOAD_RADIUS; dx <= CHUNK_LOAD_RADIUS; dx++) {
+            IslandChunk* chunk = loadIslandChunk(manager->worldSeed, &manager->settings, fcx + dx, fcz + dz,
+                manager->originCx, manager->originCz);
+            if (chunk && !adoptChunk(manager, chunk)) freeIslandChunk(chunk);
+        }
+    }
+
+    // This can run on the world builder thread, so the time is kept on the manager
+    prebuildIslandsNear(manager, focus, ISLAND_PREBUILD_RANGE);
+    manager->generationTicks = profileStart() - start;
+
+    for (int i = 0; i < manager->chunkCount; i++) {
+        if (!manager->chunks[i]->fromCache) saveIslandCache(manager->chunks[i], &manager->settings);
+    }
+}
+
+static void adoptPrefetchedChunks(IslandManager* manager);
+
+// Keeps the chunks around focus resident, prefetches the ones ahead of where
+// focus is heading and evicts the least recently used over CHUNK_MEMORY_BUDGET
+void streamIslandChunks(IslandManager* manager, Vec3 focus) {
+    adoptPrefetchedChunks(manager);
+
+    // Anything in the load radius has to be there now, prefetched or not
+    int fcx, fcz;
+    localChunk(manager, focus, &fcx, &fcz);
+    for (int dz = -CHUNK_LOAD_RADIUS; dz <= CHUNK_LOAD_RADIUS; dz++) {
+        for (int dx = -CHUNK_LOAD_RADIUS; dx <= CHUNK_LOAD_RADIUS; dx++) {
+            int index = findChunk(manager, fcx + dx, fcz + dz);
+            if (index != -1) {
+                manager->chunks[index]->lastUsedFrame = manager->frame;
+                continue;
             }
 
-            attempts++;
-            if (attempts > 100) {
-                x = 0;
-                z = 0;
-                break; // Give up after too many attempts
+            IslandChunk* chunk = loadIslandChunk(manager->worldSeed, &manager->settings, fcx + dx, fcz + dz,
+                manager->originCx, manager->originCz);
+            if (chunk && !adoptChunk(manager, chunk)) freeIslandChunk(chunk);
+        }
+    }
+
+    // Prefetch around the point CHUNK_PREFETCH_DISTANCE along the heading
+    if (manager->hasFocus) {
+        float headX = focus.x - manager->lastFocus.x;
+        float headZ = focus.z - manager->lastFocus.z;
+        float len = sqrtf(headX * headX + headZ * headZ);
+        if (len > 0.001f) {
+            Vec3 ahead = { focus.x + headX / len * CHUNK_PREFETCH_DISTANCE, 0.0f,
+                focus.z + headZ / len * CHUNK_PREFETCH_DISTANCE };
+            int acx, acz;
+            localChunk(manager, ahead, &acx, &acz);
+            for (int dz = -CHUNK_LOAD_RADIUS; dz <= CHUNK_LOAD_RADIUS; dz++) {
+                for (int dx = -CHUNK_LOAD_RADIUS; dx <= CHUNK_LOAD_RADIUS; dx++) {
+                    if (findChunk(manager, acx + dx, acz + dz) != -1) continue;
+                    requestChunkPrefetch(manager->worldSeed, &manager->settings, acx + dx, acz + dz,
+                        manager->originCx, manager->originCz);
+                }
             }
-        } while (!validPosition);
+        }
+    }
+    manager->lastFocus = focus;
+    manager->hasFocus = true;
 
-        createIsland(manager, x, z);
+    // Over budget: drop chunks nobody used this frame, oldest first
+    size_t total = 0;
+    for (int i = 0; i < manager->chunkCount; i++) {
+        total += islandChunkBytes(manager->chunks[i]);
+    }
+    while (total > CHUNK_MEMORY_BUDGET) {
+        int victim = leastRecentlyUsedChunk(manager);
+        if (victim == -1) break;
+        total -= islandChunkBytes(manager->chunks[victim]);
+        evictChunk(manager, victim);
     }
 }
 
-Island* createIsland(IslandManager* manager, float x, float z) {
-    if (manager->count >= MAX_ISLANDS) return NULL;
+// Move every resident island to be relative to another origin chunk
+static void setIslandOrigin(IslandManager* manager, int originCx, int originCz) {
+    float dx = (manager->originCx - originCx) * manager->settings.chunkSize;
+    float dz = (manager->originCz - originCz) * manager->settings.chunkSize;
 
-    Island* island = (Island*)calloc(1, sizeof(Island));
-    if (!island) return NULL;
+    for (int i = 0; i < manager->chunkCount; i++) {
+        rebaseIslandChunk(manager->chunks[i], &manager->settings, originCx, originCz);
+    }
+    manager->lastFocus.x += dx;
+    manager->lastFocus.z += dz;
+    manager->originCx = originCx;
+    manager->originCz = originCz;
+    rebuildResidentIslands(manager);
+}
 
-    float randRadius = randomFloatMan(ISLAND_MIN_RADIUS, ISLAND_MAX_RADIUS);
+// Once the focus gets ORIGIN_REBASE_DISTANCE away from the origin, the origin moves
+// to the focus chunk. Islands are only offset (meshes and kd-trees are island-relative);
+// everything else positioned in local space has to add (shiftX, shiftZ) when this returns true
+bool rebaseIslandOrigin(IslandManager* manager, Vec3 focus, float* shiftX, float* shiftZ) {
+    if (fabsf(focus.x) < ORIGIN_REBASE_DISTANCE && fabsf(focus.z) < ORIGIN_REBASE_DISTANCE) return false;
 
-    island->position.x = x;
-    island->position.y = -2.0f;
-    island->position.z = z;
-    island->radius = randRadius;
+    int stepX = chunkCoord(&manager->settings, focus.x);
+    int stepZ = chunkCoord(&manager->settings, focus.z);
+    *shiftX = -stepX * manager->settings.chunkSize;
+    *shiftZ = -stepZ * manager->settings.chunkSize;
 
-    initIsland(island, randRadius);
+    setIslandOrigin(manager, manager->originCx + stepX, manager->originCz + stepZ);
+    return true;
+}
 
-    manager->islands[manager->count++] = island;
-    return island;
+// The frame's occlusion buffer from the nearby islands' occluder boxes, which come with
+// the parameters so nothing has to be built for it. Boxes off screen or behind the camera
+// fall out in the rasterizer
+void buildIslandOcclusion(IslandManager* manager, OcclusionBuffer* buffer, Mtx44 projection, Mtx modelview, Vec3 viewPos) {
+    u64 start = profileStart();
+    beginOcclusion(buffer, projection, modelview);
+    for (int i = 0; manager && i < manager->count; i++) {
+        Island* island = manager->islands[i];
+        if (!island || !island->isInitialized) continue;
+        if (boundsDistance(island, viewPos) > ISLAND_OCCLUDER_RANGE) continue;
+        addIslandOccluders(island, buffer);
+    }
+    finishOcclusion(buffer);
+    profileStop(PROF_OCCLUSION_CULLING, start);
 }
 
-void drawAllIslands(IslandManager* manager) {
+// Frustum test for a batch of islands, then the ones that pass and aren't hidden are drawn
+// Hidden islands aren't stamped as used: one that was drawn recently stays protected for
+// ISLAND_IDLE_FRAMES anyway, one that stays hidden longer can be trimmed like any other
+static void drawIslandBatch(IslandManager* manager, Island** islands, const SphereBatch* spheres,
+    const Frustum* frustum, const OcclusionBuffer* occlusion, Vec3 viewPos, Mtx modelview) {
+    u8 visible[FRUSTUM_BATCH];
+    int count = cullSphereBatch(frustum, spheres, visible);
+    profileCount(PROF_ISLANDS_CULLED, spheres->count - count);
+
+    for (int v = 0; v < count; v++) {
+        Island* island = islands[visible[v]];
+        if (occlusion && boxOccluded(occlusion, island->boundsMin, island->boundsMax)) {
+            profileCount(PROF_ISLANDS_OCCLUDED, 1);
+            continue;
+        }
+        island->lastUsedFrame = manager->frame;
+        drawIsland(island, modelview, viewPos);
+        if (boundsDistance(island, viewPos) <= PROP_DRAW_DISTANCE) drawIslandProps(island, viewPos, occlusion);
+    }
+}
+
+// Islands within draw distance and inside the frustum get their mesh built the first time
+// they show up, and their props once they come within PROP_DRAW_DISTANCE
+// Each island loads its own offset on top of modelview, which is loaded again at the end
+void drawAllIslands(IslandManager* manager, Vec3 viewPos, Mtx modelview, const Frustum* frustum,
+    const OcclusionBuffer* occlusion) {
     if (!manager) return;
 
+    // Bounding spheres around the bounds boxes, tested FRUSTUM_BATCH at a time
+    Island* batched[FRUSTUM_BATCH];
+    SphereBatch spheres;
+    spheres.count = 0;
     for (int i = 0; i < manager->count; i++) {
-        if (manager->islands[i] && manager->islands[i]->isInitialized) {
-            drawIsland(manager->islands[i]);
+        Island* island = manager->islands[i];
+        if (!island || !island->isInitialized) continue;
+        if (boundsDistance(island, viewPos) > ISLAND_DRAW_DISTANCE) continue;
+
+        float hx = (island->boundsMax.x - island->boundsMin.x) * 0.5f;
+        float hy = (island->boundsMax.y - island->boundsMin.y) * 0.5f;
+        float hz = (island->boundsMax.z - island->boundsMin.z) * 0.5f;
+        batched[spheres.count] = island;
+        addSphere(&spheres, island->boundsMin.x + hx, island->boundsMin.y + hy, island->boundsMin.z + hz,
+            sqrtf(hx * hx + hy * hy + hz * hz));
+        if (spheres.count == FRUSTUM_BATCH) {
+            drawIslandBatch(manager, batched, &spheres, frustum, occlusion, viewPos, modelview);
+            spheres.count = 0;
         }
     }
+    if (spheres.count > 0) drawIslandBatch(manager, batched, &spheres, frustum, occlusion, viewPos, modelview);
+    GX_LoadPosMtxImm(modelview, GX_PNMTX0);
 }
 
 bool checkAllIslandsCollision(IslandManager* manager, Vec3 position, float radius) {
     if (!manager) return false;
 
-    for (int i = 0; i < manager->count; i++) {
-        if (manager->islands[i] &&
-            checkIslandCollision(manager->islands[i], position, radius)) {
+    Island* candidates[MAX_QUERY_ISLANDS];
+    int found = gatherIslands(manager, position.x - radius, position.z - radius,
+        position.x + radius, position.z + radius, candidates);
+
+    for (int i = 0; i < found; i++) {
+        if (position.y - radius > candidates[i]->boundsMax.y ||
+            position.y + radius < candidates[i]->boundsMin.y) continue;
+
+        if (checkIslandCollision(candidates[i], position, radius)) {
             return true;
         }
     }
@@ -136,8 +493,12 @@ float islandGroundHeight(IslandManager* manager, Vec3 position, float radius) {
 
     float lowest = position.y;
 
-    for (int i = 0; i < manager->count; i++) {
-        float triHeight = getIslandTriangleHeight(manager->islands[i], position, radius);
+    Island* candidates[MAX_QUERY_ISLANDS];
+    int found = gatherIslands(manager, position.x - radius, position.z - radius,
+        position.x + radius, position.z + radius, candidates);
+
+    for (int i = 0; i < found; i++) {
+        float triHeight = getIslandTriangleHeight(candidates[i], position, radius);
         if (triHeight < lowest) {
             lowest = triHeight;
         }
@@ -145,12 +506,57 @@ float islandGroundHeight(IslandManager* manager, Vec3 position, float radius) {
     return lowest;
 }
 
+// Signed distance to the nearest coastline in the XZ plane (negative on land)
+// gradient (optional) points away from the closest island's coast
+float shoreDistance(IslandManager* manager, Vec3 position, Vec3* gradient) {
+    float closest = FLT_MAX;
+    if (!manager) return closest;
+
+    Island* candidates[MAX_QUERY_ISLANDS];
+    int found = gatherIslands(manager, position.x - SHORE_QUERY_RANGE, position.z - SHORE_QUERY_RANGE,
+        position.x + SHORE_QUERY_RANGE, position.z + SHORE_QUERY_RANGE, candidates);
+
+    for (int i = 0; i < found; i++) {
+        Vec3 islandGradient;
+        float dist = islandShoreDistance(candidates[i], position.x, position.z, gradient ? &islandGradient : NULL);
+        if (dist < closest) {
+            closest = dist;
+            if (gradient) *gradient = islandGradient;
+        }
+    }
+    return closest;
+}
+
+// Distance to the first island hit along a normalized ray, maxDist if the ray is clear
+float raycastIslands(IslandManager* manager, Vec3 origin, Vec3 dir, float maxDist) {
+    if (!manager) return maxDist;
+
+    Vec3 end = { origin.x + dir.x * maxDist, origin.y + dir.y * maxDist, origin.z + dir.z * maxDist };
+
+    Island* candidates[MAX_QUERY_ISLANDS];
+    int found = gatherIslands(manager,
+        fminf(origin.x, end.x), fminf(origin.z, end.z),
+        fmaxf(origin.x, end.x), fmaxf(origin.z, end.z), candidates);
+
+    float closest = maxDist;
+    for (int i = 0; i < found; i++) {
+        closest = islandRaycast(candidates[i], origin, dir, closest);
+    }
+    return closest;
+}
+
 // Determines if there is anything between the player and the camera
 bool checkCameraPlayerCovered(Vec3 cameraPos, Vec3 playerPos, IslandManager* manager) {
     if (!manager) return false;
 
-    for (int i = 0; i < manager->count; i++) {
-        if (cameraCoveredCheck(cameraPos, playerPos, manager->islands[i])) {
+    // Only islands overlapping the camera-player segment can block it
+    Island* candidates[MAX_QUERY_ISLANDS];
+    int found = gatherIslands(manager,
+        fminf(cameraPos.x, playerPos.x), fminf(cameraPos.z, playerPos.z),
+        fmaxf(cameraPos.x, playerPos.x), fmaxf(cameraPos.z, playerPos.z), candidates);
+
+    for (int i = 0; i < found; i++) {
+        if (cameraCoveredCheck(cameraPos, playerPos, candidates[i])) {
             return true;
         }
     }
@@ -158,14 +564,334 @@ bool checkCameraPlayerCovered(Vec3 cameraPos, Vec3 playerPos, IslandManager* man
     return false;
 }
 
+// Whether one island's water mask covers the whole XZ rectangle, so water there can't show
+bool islandsCoverRect(IslandManager* manager, float minX, float minZ, float maxX, float maxZ) {
+    if (!manager) return false;
+
+    Island* candidates[MAX_QUERY_ISLANDS];
+    int found = gatherIslands(manager, minX, minZ, maxX, maxZ, candidates);
+    for (int i = 0; i < found; i++) {
+        if (islandCoversRect(candidates[i], minX, minZ, maxX, maxZ)) return true;
+    }
+    return false;
+}
+
 void freeAllIslands(IslandManager* manager) {
-    for (int i = 0; i < manager->count; i++) {
-        if (manager->islands[i]) {
-            freeIslandResources(manager->islands[i]);
-            free(manager->islands[i]);
-            manager->islands[i] = NULL;
+    releaseIslands(manager);
+
+    free(manager->islands);
+    manager->islands = NULL;
+    manager->capacity = 0;
+
+    free(manager->gridEntries);
+    manager->gridEntries = NULL;
+    manager->gridEntryCapacity = 0;
+}
+
+void islandMemoryStats(const IslandManager* manager, ArenaStats* chunkStats, ArenaStats* stageStats) {
+    memset(chunkStats, 0, sizeof(*chunkStats));
+    memset(stageStats, 0, sizeof(*stageStats));
+
+    for (int c = 0; c < manager->chunkCount; c++) {
+        const IslandChunk* chunk = manager->chunks[c];
+        arenaAddStats(&chunk->arena, chunkStats);
+        for (int i = 0; i < chunk->count; i++) {
+            arenaAddStats(&chunk->islands[i]->meshArena, stageStats);
+            arenaAddStats(&chunk->islands[i]->collisionArena, stageStats);
         }
     }
-    manager->count = 0;
 }
 
+
+// ---------------------------------------------------------------------------
+// Background world builder: regenerates a full island set off the render thread
+// while the current one stays drawable, frees retired sets afterwards and
+// prefetches chunks the streamer asked for.
+
+#define WORLD_BUILDER_STACK_SIZE  (64*1024)
+#define WORLD_BUILDER_PRIORITY    32   // Below the main loop so frames keep coming; its
+                                       // parallel-for jobs run inline at this priority too
+#define MAX_RETIRED_WORLDS        4
+
+typedef struct {
+    u64 worldSeed;
+    ChunkSettings settings;
+    int cx, cz;
+    int originCx, originCz;
+} ChunkRequest;
+
+static struct {
+    lwp_t thread;
+    u8* stack;
+    mutex_t lock;
+    cond_t wake;
+    bool started;
+    bool quit;
+
+    bool requested;
+    u64 requestedSeed;
+    Vec3 requestedFocus;
+    int requestedOriginCx, requestedOriginCz;
+    IslandManager* ready;  // Finished set waiting for the next frame boundary
+
+    IslandManager* retired[MAX_RETIRED_WORLDS];
+    int retiredCount;
+
+    // Chunk prefetch: queued, being built, and finished waiting for adoption
+    ChunkRequest chunkRequests[MAX_PENDING_CHUNKS];
+    int chunkRequestCount;
+    ChunkRequest chunkInFlight;
+    bool chunkBusy;
+    IslandChunk* readyChunks[MAX_PENDING_CHUNKS];
+    int readyChunkCount;
+} worldBuilder;
+
+static bool sameChunk(const ChunkRequest* request, u64 worldSeed, int cx, int cz) {
+    return request->worldSeed == worldSeed && request->cx == cx && request->cz == cz;
+}
+
+// Load a requested chunk with all its islands built, and cache it for next time
+// Runs on the builder thread, so prebuildIslands works through the islands inline there
+// instead of taking the worker pool from the frame
+static IslandChunk* buildPrefetchedChunk(const ChunkRequest* request) {
+    IslandChunk* chunk = loadIslandChunk(request->worldSeed, &request->settings, request->cx, request->cz,
+        request->originCx, request->originCz);
+    if (!chunk) return NULL;
+
+    Vec3 center = { 0.0f, 0.0f, 0.0f };
+    chunkCenter(chunk, &request->settings, &center.x, &center.z);
+    prebuildIslands(chunk->islands, chunk->count, center, request->settings.chunkSize);
+
+    if (!chunk->fromCache) saveIslandCache(chunk, &request->settings);
+    return chunk;
+}
+
+static void destroyWorld(IslandManager* world) {
+    freeAllIslands(world);
+    free(world);
+}
+
+static void* worldBuilderMain(void* arg) {
+    LWP_MutexLock(worldBuilder.lock);
+    while (1) {
+        while (!worldBuilder.quit && !worldBuilder.requested && worldBuilder.retiredCount == 0 &&
+            worldBuilder.chunkRequestCount == 0) {
+            LWP_CondWait(worldBuilder.wake, worldBuilder.lock);
+        }
+        if (worldBuilder.quit) break;
+
+        // Free old sets first, they hold the most memory
+        if (worldBuilder.retiredCount > 0) {
+            IslandManager* old = worldBuilder.retired[--worldBuilder.retiredCount];
+            LWP_MutexUnlock(worldBuilder.lock);
+            destroyWorld(old);
+            LWP_MutexLock(worldBuilder.lock);
+            continue;
+        }
+
+        // Then chunk prefetch, unless a whole new world is waiting
+        if (!worldBuilder.requested) {
+            worldBuilder.chunkInFlight = worldBuilder.chunkRequests[0];
+            worldBuilder.chunkBusy = true;
+            worldBuilder.chunkRequestCount--;
+            for (int i = 0; i < worldBuilder.chunkRequestCount; i++) {
+                worldBuilder.chunkRequests[i] = worldBuilder.chunkRequests[i + 1];
+            }
+            ChunkRequest request = worldBuilder.chunkInFlight;
+            LWP_MutexUnlock(worldBuilder.lock);
+
+            IslandChunk* chunk = buildPrefetchedChunk(&request);
+
+            LWP_MutexLock(worldBuilder.lock);
+            worldBuilder.chunkBusy = false;
+            if (chunk && worldBuilder.readyChunkCount < MAX_PENDING_CHUNKS) {
+                worldBuilder.readyChunks[worldBuilder.readyChunkCount++] = chunk;
+                chunk = NULL;
+            }
+            if (chunk) {
+                LWP_MutexUnlock(worldBuilder.lock);
+                freeIslandChunk(chunk);
+                LWP_MutexLock(worldBuilder.lock);
+            }
+            continue;
+        }
+
+        u64 seed = worldBuilder.requestedSeed;
+        Vec3 focus = worldBuilder.requestedFocus;
+        int originCx = worldBuilder.requestedOriginCx;
+        int originCz = worldBuilder.requestedOriginCz;
+        worldBuilder.requested = false;
+        LWP_MutexUnlock(worldBuilder.lock);
+
+        IslandManager* next = (IslandManager*)malloc(sizeof(IslandManager));
+        if (next) {
+            initIslandManager(next, seed);
+            next->originCx = originCx;
+            next->originCz = originCz;
+            regenerateIslands(next, focus);
+        }
+
+        LWP_MutexLock(worldBuilder.lock);
+        if (worldBuilder.ready) {
+            // A newer request finished before the last one was swapped in
+            IslandManager* superseded = worldBuilder.ready;
+            LWP_MutexUnlock(worldBuilder.lock);
+            destroyWorld(superseded);
+            LWP_MutexLock(worldBuilder.lock);
+        }
+        worldBuilder.ready = next;
+    }
+    LWP_MutexUnlock(worldBuilder.lock);
+    return NULL;
+}
+
+void initWorldBuilder() {
+    if (worldBuilder.started) return;
+
+    LWP_MutexInit(&worldBuilder.lock, false);
+    LWP_CondInit(&worldBuilder.wake);
+    worldBuilder.quit = false;
+    worldBuilder.requested = false;
+    worldBuilder.ready = NULL;
+    worldBuilder.retiredCount = 0;
+    worldBuilder.chunkRequestCount = 0;
+    worldBuilder.chunkBusy = false;
+    worldBuilder.readyChunkCount = 0;
+
+    worldBuilder.stack = (u8*)memalign(32, WORLD_BUILDER_STACK_SIZE);
+    LWP_CreateThread(&worldBuilder.thread, worldBuilderMain, NULL,
+        worldBuilder.stack, WORLD_BUILDER_STACK_SIZE, WORLD_BUILDER_PRIORITY);
+    worldBuilder.started = true;
+}
+
+// Ask for a new island set; the current one keeps working until the swap
+// Islands around focus come with their meshes and collision already built
+// focus is relative to the origin chunk (originCx, originCz) of the current set
+void requestIslandRegeneration(u64 worldSeed, Vec3 focus, int originCx, int originCz) {
+    LWP_MutexLock(worldBuilder.lock);
+    worldBuilder.requested = true;
+    worldBuilder.requestedSeed = worldSeed;
+    worldBuilder.requestedFocus = focus;
+    worldBuilder.requestedOriginCx = originCx;
+    worldBuilder.requestedOriginCz = originCz;
+    worldBuilder.chunkRequestCount = 0;  // Those belong to the old world
+    LWP_CondSignal(worldBuilder.wake);
+    LWP_MutexUnlock(worldBuilder.lock);
+}
+
+// Queue a chunk to be loaded and built in the background
+// Returns false when the queue is full; asking again for a queued chunk is fine
+bool requestChunkPrefetch(u64 worldSeed, const ChunkSettings* settings, int cx, int cz, int originCx, int originCz) {
+    if (!worldBuilder.started) return false;
+
+    LWP_MutexLock(worldBuilder.lock);
+    bool queued = worldBuilder.chunkBusy && sameChunk(&worldBuilder.chunkInFlight, worldSeed, cx, cz);
+    for (int i = 0; i < worldBuilder.chunkRequestCount && !queued; i++) {
+        queued = sameChunk(&worldBuilder.chunkRequests[i], worldSeed, cx, cz);
+    }
+    for (int i = 0; i < worldBuilder.readyChunkCount && !queued; i++) {
+        IslandChunk* chunk = worldBuilder.readyChunks[i];
+        queued = chunk->worldSeed == worldSeed && chunk->cx == cx && chunk->cz == cz;
+    }
+
+    // Everything queued has to fit the ready list once it's built
+    int outstanding = worldBuilder.chunkRequestCount + worldBuilder.readyChunkCount + (worldBuilder.chunkBusy ? 1 : 0);
+    if (!queued && outstanding < MAX_PENDING_CHUNKS) {
+        ChunkRequest* request = &worldBuilder.chunkRequests[worldBuilder.chunkRequestCount++];
+        request->worldSeed = worldSeed;
+        request->settings = *settings;
+        request->cx = cx;
+        request->cz = cz;
+        request->originCx = originCx;
+        request->originCz = originCz;
+        LWP_CondSignal(worldBuilder.wake);
+        queued = true;
+    }
+    LWP_MutexUnlock(worldBuilder.lock);
+    return queued;
+}
+
+// Take the chunks the builder finished; ones for another world or already
+// loaded on the main thread in the meantime are dropped
+static void adoptPrefetchedChunks(IslandManager* manager) {
+    if (!worldBuilder.started) return;
+
+    IslandChunk* finished[MAX_PENDING_CHUNKS];
+    LWP_MutexLock(worldBuilder.lock);
+    int count = worldBuilder.readyChunkCount;
+    for (int i = 0; i < count; i++) {
+        finished[i] = worldBuilder.readyChunks[i];
+    }
+    worldBuilder.readyChunkCount = 0;
+    LWP_MutexUnlock(worldBuilder.lock);
+
+    for (int i = 0; i < count; i++) {
+        IslandChunk* chunk = finished[i];
+        if (chunk->worldSeed != manager->worldSeed || findChunk(manager, chunk->cx, chunk->cz) != -1 ||
+            !adoptChunk(manager, chunk)) {
+            freeIslandChunk(chunk);
+        }
+    }
+}
+
+// Call at a frame boundary: swaps in a finished set and retires the old one
+// Returns true when the world changed
+bool swapRegeneratedIslands(IslandManager* manager) {
+    LWP_MutexLock(worldBuilder.lock);
+    IslandManager* next = worldBuilder.ready;
+    worldBuilder.ready = NULL;
+    LWP_MutexUnlock(worldBuilder.lock);
+
+    if (!next) return false;
+
+    profileAddTicks(PROF_ISLAND_GENERATION, next->generationTicks);
+
+    // The origin may have moved while the new set was being built
+    if (next->originCx != manager->originCx || next->originCz != manager->originCz) {
+        setIslandOrigin(next, manager->originCx, manager->originCz);
+    }
+
+    // Swap contents so callers keep using the same manager pointer
+    IslandManager old = *manager;
+    *manager = *next;
+    *next = old;
+
+    LWP_MutexLock(worldBuilder.lock);
+    if (worldBuilder.retiredCount < MAX_RETIRED_WORLDS) {
+        worldBuilder.retired[worldBuilder.retiredCount++] = next;
+        LWP_CondSignal(worldBuilder.wake);
+        next = NULL;
+    }
+    LWP_MutexUnlock(worldBuilder.lock);
+
+    // Retire queue full, free it here rather than leak
+    if (next) destroyWorld(next);
+    return true;
+}
+
+void shutdownWorldBuilder() {
+    if (!worldBuilder.started) return;
+
+    LWP_MutexLock(worldBuilder.lock);
+    worldBuilder.quit = true;
+    LWP_CondSignal(worldBuilder.wake);
+    LWP_MutexUnlock(worldBuilder.lock);
+    LWP_JoinThread(worldBuilder.thread, NULL);
+
+    if (worldBuilder.ready) destroyWorld(worldBuilder.ready);
+    for (int i = 0; i < worldBuilder.retiredCount; i++) {
+        destroyWorld(worldBuilder.retired[i]);
+    }
+    for (int i = 0; i < worldBuilder.readyChunkCount; i++) {
+        freeIslandChunk(worldBuilder.readyChunks[i]);
+    }
+    worldBuilder.ready = NULL;
+    worldBuilder.retiredCount = 0;
+    worldBuilder.chunkRequestCount = 0;
+    worldBuilder.readyChunkCount = 0;
+
+    LWP_CondDestroy(worldBuilder.wake);
+    LWP_MutexDestroy(worldBuilder.lock);
+    free(worldBuilder.stack);
+    worldBuilder.started = false;
+}
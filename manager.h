@@ -2,23 +2,99 @@
 #define ISLAND_MANAGER_H
 
 #include "island.h"
+#include "chunks.h"
+#include "frustum.h"
+#include "occlusion.h"
 #include "common.h"
 
-#define MAX_ISLANDS 10
+// Broad phase: uniform grid over island bounds, hashed into a fixed bucket table
+#define ISLAND_GRID_CELL      32.0f
+#define ISLAND_GRID_BUCKETS   1024
+#define MAX_QUERY_ISLANDS     64    // Most islands a single world query can visit
+#define SHORE_QUERY_RANGE     8.0f  // Islands further than this are ignored by shoreDistance
+
+// Meshes and collision data are built on demand and dropped again when idle
+// A built noise island is about 530 KB (mostly kd nodes), a polar one about 85 KB; the
+// budget holds the resident chunks' usual mix with room for a few prefetched ones
+#define ISLAND_DRAW_DISTANCE    100.0f             // Matches the far clipping plane
+#define ISLAND_PREBUILD_RANGE   100.0f             // Built ahead of time around the focus of a new world
+#define ISLAND_MEMORY_BUDGET    (4 * 1024 * 1024)  // Heap bytes of built island data before idle ones are dropped
+#define ISLAND_IDLE_FRAMES      120                // Frames without use before an island counts as idle
+#define ISLAND_OCCLUDER_RANGE   60.0f              // Islands further out are too small on screen to occlude much
+
+// Chunk streaming around the focus (boat or player)
+#define CHUNK_LOAD_RADIUS        1                  // Chunks this many steps from the focus chunk are always resident
+#define CHUNK_PREFETCH_DISTANCE  (CHUNK_SIZE * 1.5f) // How far ahead of the heading chunks are requested
+#define MAX_RESIDENT_CHUNKS      32
+#define CHUNK_MEMORY_BUDGET      (3 * 1024 * 1024)  // Resident chunk bytes before the least recently used go
+#define MAX_PENDING_CHUNKS       8                  // Prefetch requests queued on the world builder
+
+// Floating origin: positions are kept relative to an origin chunk that follows the focus,
+// so floats stay precise no matter how far out the world goes
+#define ORIGIN_REBASE_DISTANCE   (CHUNK_SIZE * 2.0f) // Focus this far from the origin moves the origin
 
 typedef struct {
-    Island* islands[MAX_ISLANDS];
+    int cellX, cellZ;
+    int island;  // Index into IslandManager.islands
+    int next;    // Next entry in the same bucket, -1 ends the chain
+} IslandGridEntry;
+
+typedef struct {
+    // Islands of every resident chunk, all that queries and drawing ever see
+    Island** islands;
     int count;
+    int capacity;
+
+    IslandChunk* chunks[MAX_RESIDENT_CHUNKS];
+    int chunkCount;
+    ChunkSettings settings;
+    Vec3 lastFocus;  // For the heading used by prefetch
+    bool hasFocus;
+    int originCx, originCz;  // Chunk at local (0, 0); world = local + origin * chunkSize
+
+    int gridHeads[ISLAND_GRID_BUCKETS];
+    IslandGridEntry* gridEntries;
+    int gridEntryCount;
+    int gridEntryCapacity;
+    unsigned int queryStamp;
+    unsigned int frame;  // Advanced by trimIslandMemory, stamps lastUsedFrame
+
+    u64 worldSeed;  // Same seed, same world
+    u64 generationTicks;  // Time the last regenerateIslands took
 } IslandManager;
 
-void initIslandManager(IslandManager* manager);
-Island* createIsland(IslandManager* manager, float x, float z);
-void drawAllIslands(IslandManager* manager);
+void initIslandManager(IslandManager* manager, u64 worldSeed);
+void buildIslandOcclusion(IslandManager* manager, OcclusionBuffer* buffer, Mtx44 projection, Mtx modelview, Vec3 viewPos);
+void drawAllIslands(IslandManager* manager, Vec3 viewPos, Mtx modelview, const Frustum* frustum,
+    const OcclusionBuffer* occlusion);
 bool checkAllIslandsCollision(IslandManager* manager, Vec3 position, float radius);
 void freeAllIslands(IslandManager* manager);
 float islandGroundHeight(IslandManager* manager, Vec3 position, float radius);
-void regenerateIslands(IslandManager* manager);  // Add this line
+void regenerateIslands(IslandManager* manager, Vec3 focus);
 void drawIndicator(Vec3 position);
+float shoreDistance(IslandManager* manager, Vec3 position, Vec3* gradient);
+float raycastIslands(IslandManager* manager, Vec3 origin, Vec3 dir, float maxDist);
 bool checkCameraPlayerCovered(Vec3 cameraPos, Vec3 playerPos, IslandManager* manager);
+bool islandsCoverRect(IslandManager* manager, float minX, float minZ, float maxX, float maxZ);
+
+// Region memory of the resident chunks: chunk arenas plus every island's stage regions
+void islandMemoryStats(const IslandManager* manager, ArenaStats* chunkStats, ArenaStats* stageStats);
+
+// Chunk streaming, once per frame after trimIslandMemory
+void streamIslandChunks(IslandManager* manager, Vec3 focus);
+
+// Floating origin, call with the focus before streaming
+bool rebaseIslandOrigin(IslandManager* manager, Vec3 focus, float* shiftX, float* shiftZ);
+
+// On-demand island data
+void prebuildIslandsNear(IslandManager* manager, Vec3 focus, float range);
+void trimIslandMemory(IslandManager* manager);
+
+// Background regeneration with a swap at the frame boundary
+void initWorldBuilder();
+void requestIslandRegeneration(u64 worldSeed, Vec3 focus, int originCx, int originCz);
+bool swapRegeneratedIslands(IslandManager* manager);
+bool requestChunkPrefetch(u64 worldSeed, const ChunkSettings* settings, int cx, int cz, int originCx, int originCz);
+void shutdownWorldBuilder();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include <math.h>
+#include "noise.h"
+
+#define NOISE_WARP_OCTAVES  3  // The warp field only needs the broad shapes
+
+// Lattice hash to [-1, 1]
+static float latticeValue(u32 seed, int x, int z) {
+    u32 h = seed ^ ((u32)x * 0x27d4eb2du) ^ ((u32)z * 0x165667b1u);
+    h ^= h >> 15;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return (float)(h & 0xffff) * (2.0f / 65535.0f) - 1.0f;
+}
+
+// One octave of value noise over a batch (count <= NOISE_BATCH)
+static void valueNoiseBatch(u32 seed, const float* x, const float* z, float* out, int count) {
+    int ix[NOISE_BATCH], iz[NOISE_BATCH];
+    float fx[NOISE_BATCH], fz[NOISE_BATCH];
+
+    // Cell and fractional position, floor without a call or a branch
+    for (int i = 0; i < count; i++) {
+        int cx = (int)x[i];
+        int cz = (int)z[i];
+        cx -= x[i] < (float)cx;
+        cz -= z[i] < (float)cz;
+        ix[i] = cx;
+        iz[i] = cz;
+        fx[i] = x[i] - (float)cx;
+        fz[i] = z[i] - (float)cz;
+    }
+
+    // Quintic fade, so octaves don't show the lattice as creases
+    for (int i = 0; i < count; i++) {
+        float u = fx[i], v = fz[i];
+        fx[i] = u * u * u * (u * (u * 6.0f - 15.0f) + 10.0f);
+        fz[i] = v * v * v * (v * (v * 6.0f - 15.0f) + 10.0f);
+    }
+
+    for (int i = 0; i < count; i++) {
+        float a = latticeValue(seed, ix[i], iz[i]);
+        float b = latticeValue(seed, ix[i] + 1, iz[i]);
+        float c = latticeValue(seed, ix[i], iz[i] + 1);
+        float d = latticeValue(seed, ix[i] + 1, iz[i] + 1);
+        float top = a + (b - a) * fx[i];
+        float bottom = c + (d - c) * fx[i];
+        out[i] = top + (bottom - top) * fz[i];
+    }
+}
+
+// Octave sum over a batch, normalized by the total amplitude
+static void fbmBatch(u32 seed, const NoiseParams* params, int octaves,
+    const float* x, const float* z, float* out, int count) {
+    float sx[NOISE_BATCH], sz[NOISE_BATCH], octave[NOISE_BATCH];
+
+    for (int i = 0; i < count; i++) out[i] = 0.0f;
+
+    float frequency = params->frequency;
+    float amplitude = 1.0f;
+    float total = 0.0f;
+    for (int o = 0; o < octaves; o++) {
+        for (int i = 0; i < count; i++) {
+            sx[i] = x[i] * frequency;
+            sz[i] = z[i] * frequency;
+        }
+        // Each octave gets its own lattice, otherwise they line up at the origin
+        valueNoiseBatch(seed + (u32)o * 0x9e3779b9u, sx, sz, octave, count);
+        for (int i = 0; i < count; i++) {
+            out[i] += octave[i] * amplitude;
+        }
+
+        total += amplitude;
+        frequency *= params->lacunarity;
+        amplitude *= params->gain;
+    }
+
+    float scale = total > 0.0f ? 1.0f / total : 0.0f;
+    for (int i = 0; i < count; i++) out[i] *= scale;
+}
+
+void noiseFbmBatch(const NoiseParams* params, const float* x, const float* z, float* out, int count) {
+    int octaves = params->octaves;
+    if (octaves < 1) octaves = 1;
+    if (octaves > NOISE_MAX_OCTAVES) octaves = NOISE_MAX_OCTAVES;
+    int warpOctaves = octaves < NOISE_WARP_OCTAVES ? octaves : NOISE_WARP_OCTAVES;
+
+    float wx[NOISE_BATCH], wz[NOISE_BATCH];
+    float offsetX[NOISE_BATCH], offsetZ[NOISE_BATCH];
+
+    for (int start = 0; start < count; start += NOISE_BATCH) {
+        int n = count - start < NOISE_BATCH ? count - start : NOISE_BATCH;
+        const float* bx = x + start;
+        const float* bz = z + start;
+
+        if (params->warp == 0.0f) {
+            fbmBatch(params->seed, params, octaves, bx, bz, out + start, n);
+            continue;
+        }
+
+        // Domain warp: displace the lookup by two more noise fields, which is
+        // what bends coastlines into bays and spits
+        fbmBatch(params->seed ^ 0x68bc21ebu, params, warpOctaves, bx, bz, offsetX, n);
+        fbmBatch(params->seed ^ 0x02e5be93u, params, warpOctaves, bx, bz, offsetZ, n);
+        for (int i = 0; i < n; i++) {
+            wx[i] = bx[i] + offsetX[i] * params->warp;
+            wz[i] = bz[i] + offsetZ[i] * params->warp;
+        }
+        fbmBatch(params->seed, params, octaves, wx, wz, out + start, n);
+    }
+}
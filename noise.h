@@ -0,0 +1,24 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <gccore.h>
+
+// 2D fractal value noise with domain warping, evaluated in batches of points.
+// Every stage runs as its own flat loop over the batch (no branches, no calls),
+// so the compiler can keep it in registers and vectorize or pair it
+#define NOISE_BATCH        64   // Points per internal pass, scratch lives on the stack
+#define NOISE_MAX_OCTAVES  8
+
+typedef struct {
+    u32 seed;
+    float frequency;   // Cycles per world unit of the first octave
+    int octaves;
+    float lacunarity;  // Frequency step per octave
+    float gain;        // Amplitude step per octave
+    float warp;        // Domain warp distance in world units, 0 turns it off
+} NoiseParams;
+
+// out[i] = fractal noise at (x[i], z[i]), roughly in [-1, 1]
+void noiseFbmBatch(const NoiseParams* params, const float* x, const float* z, float* out, int count);
+
+#endif
@@ -0,0 +1,149 @@
+#include <math.h>
+#include <float.h>
+#include "occlusion.h"
+
+typedef struct {
+    float x, y;  // Buffer pixels, y down
+    float w;     // View distance
+} ScreenPoint;
+
+// Corner c of a box has max x when bit 0 is set, max y for bit 1 and max z for bit 2,
+// so the edges join corners that differ in one bit
+static const u8 boxEdges[12][2] = {
+    { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+    { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+};
+
+void beginOcclusion(OcclusionBuffer* buffer, Mtx44 projection, Mtx view) {
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            buffer->clip[r][c] = projection[r][0] * view[0][c] + projection[r][1] * view[1][c] +
+                projection[r][2] * view[2][c] + (c == 3 ? projection[r][3] : 0.0f);
+        }
+    }
+    for (int y = 0; y < OCCLUSION_HEIGHT; y++) {
+        for (int x = 0; x < OCCLUSION_WIDTH; x++) buffer->depth[y][x] = FLT_MAX;
+    }
+}
+
+// All eight corners onto the buffer, through model first when there is one
+// Gives up when a corner is too close, rather than clipping against the near plane
+static bool projectBox(const OcclusionBuffer* buffer, Mtx model, Vec3 min, Vec3 max, ScreenPoint* out) {
+    for (int c = 0; c < 8; c++) {
+        float p[3] = { (c & 1) ? max.x : min.x, (c & 2) ? max.y : min.y, (c & 4) ? max.z : min.z };
+        if (model) {
+            float local[3] = { p[0], p[1], p[2] };
+            for (int r = 0; r < 3; r++) {
+                p[r] = model[r][0] * local[0] + model[r][1] * local[1] + model[r][2] * local[2] + model[r][3];
+            }
+        }
+
+        const float (*clip)[4] = buffer->clip;
+        float w = clip[3][0] * p[0] + clip[3][1] * p[1] + clip[3][2] * p[2] + clip[3][3];
+        if (w < OCCLUSION_NEAR) return false;
+        float x = clip[0][0] * p[0] + clip[0][1] * p[1] + clip[0][2] * p[2] + clip[0][3];
+        float y = clip[1][0] * p[0] + clip[1][1] * p[1] + clip[1][2] * p[2] + clip[1][3];
+        out[c].x = (x / w * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+        out[c].y = (0.5f - y / w * 0.5f) * OCCLUSION_HEIGHT;
+        out[c].w = w;
+    }
+    return true;
+}
+
+// The outline of a projected box is made of box edges and every edge lies inside it, so a
+// row's span runs between the leftmost and rightmost edge crossing. The whole span gets the
+// box's farthest depth, which no point of the box is behind
+void addOccluderBox(OcclusionBuffer* buffer, Vec3 min, Vec3 max) {
+    ScreenPoint corners[8];
+    if (!projectBox(buffer, NULL, min, max, corners)) return;
+
+    float top = FLT_MAX, bottom = -FLT_MAX, far = 0.0f;
+    for (int c = 0; c < 8; c++) {
+        top = fminf(top, corners[c].y);
+        bottom = fmaxf(bottom, corners[c].y);
+        far = fmaxf(far, corners[c].w);
+    }
+
+    // Pixels count as covered when their center is
+    int y0 = (int)ceilf(fmaxf(top - 0.5f, 0.0f));
+    int y1 = (int)floorf(fminf(bottom - 0.5f, OCCLUSION_HEIGHT - 1));
+    for (int y = y0; y <= y1; y++) {
+        float center = y + 0.5f;
+        float left = FLT_MAX, right = -FLT_MAX;
+        for (int e = 0; e < 12; e++) {
+            const ScreenPoint* a = &corners[boxEdges[e][0]];
+            const ScreenPoint* b = &corners[boxEdges[e][1]];
+            if ((a->y <= center) == (b->y <= center)) continue;
+            float x = a->x + (center - a->y) * (b->x - a->x) / (b->y - a->y);
+            left = fminf(left, x);
+            right = fmaxf(right, x);
+        }
+        if (left > right) continue;
+
+        int x0 = (int)ceilf(fmaxf(left - 0.5f, 0.0f));
+        int x1 = (int)floorf(fminf(right - 0.5f, OCCLUSION_WIDTH - 1));
+        float* row = buffer->depth[y];
+        for (int x = x0; x <= x1; x++) row[x] = fminf(row[x], far);
+    }
+}
+
+// A pixel whose center is covered can still be partly open at its edges, and something
+// small could show through there. So each pixel keeps the farthest depth of its 3x3
+// neighbourhood, once along rows and once along columns, with the outside counting as open
+void finishOcclusion(OcclusionBuffer* buffer) {
+    for (int y = 0; y < OCCLUSION_HEIGHT; y++) {
+        float* row = buffer->depth[y];
+        float before = FLT_MAX;
+        for (int x = 0; x < OCCLUSION_WIDTH; x++) {
+            float here = row[x];
+            float after = x + 1 < OCCLUSION_WIDTH ? row[x + 1] : FLT_MAX;
+            row[x] = fmaxf(fmaxf(before, here), after);
+            before = here;
+        }
+    }
+    for (int x = 0; x < OCCLUSION_WIDTH; x++) {
+        float before = FLT_MAX;
+        for (int y = 0; y < OCCLUSION_HEIGHT; y++) {
+            float here = buffer->depth[y][x];
+            float after = y + 1 < OCCLUSION_HEIGHT ? buffer->depth[y + 1][x] : FLT_MAX;
+            buffer->depth[y][x] = fmaxf(fmaxf(before, here), after);
+            before = here;
+        }
+    }
+}
+
+// Hidden when every pixel the box's screen rectangle touches has an occluder in front of
+// the box's nearest corner. Boxes entirely off screen are left to the frustum
+static bool boxHidden(const OcclusionBuffer* buffer, Mtx model, Vec3 min, Vec3 max) {
+    ScreenPoint corners[8];
+    if (!projectBox(buffer, model, min, max, corners)) return false;
+
+    float left = FLT_MAX, right = -FLT_MAX, top = FLT_MAX, bottom = -FLT_MAX, near = FLT_MAX;
+    for (int c = 0; c < 8; c++) {
+        left = fminf(left, corners[c].x);
+        right = fmaxf(right, corners[c].x);
+        top = fminf(top, corners[c].y);
+        bottom = fmaxf(bottom, corners[c].y);
+        near = fminf(near, corners[c].w);
+    }
+    if (right < 0.0f || left >= OCCLUSION_WIDTH || bottom < 0.0f || top >= OCCLUSION_HEIGHT) return false;
+
+    int x0 = (int)fmaxf(left, 0.0f), x1 = (int)fminf(right, OCCLUSION_WIDTH - 1);
+    int y0 = (int)fmaxf(top, 0.0f), y1 = (int)fminf(bottom, OCCLUSION_HEIGHT - 1);
+    for (int y = y0; y <= y1; y++) {
+        const float* row = buffer->depth[y];
+        for (int x = x0; x <= x1; x++) {
+            if (row[x] >= near) return false;
+        }
+    }
+    return true;
+}
+
+bool boxOccluded(const OcclusionBuffer* buffer, Vec3 min, Vec3 max) {
+    return boxHidden(buffer, NULL, min, max);
+}
+
+bool boxOccludedIn(const OcclusionBuffer* buffer, Mtx model, Vec3 min, Vec3 max) {
+    return boxHidden(buffer, model, min, max);
+}
@@ -0,0 +1,32 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "common.h"
+#include "kd_tree.h"  // Vec3
+
+// Small CPU depth buffer for occlusion culling: boxes known to be solid are rasterized into
+// it each frame, then bounds are tested against it before anything goes to the GP
+#define OCCLUSION_WIDTH   64
+#define OCCLUSION_HEIGHT  48
+#define OCCLUSION_NEAR    0.5f   // Boxes reaching closer than this are neither occluders nor hidden
+
+// Depths are view distances (clip w), FLT_MAX where nothing is known to be in the way
+typedef struct {
+    float clip[4][4];  // Projection * view, the same matrices GX gets
+    float depth[OCCLUSION_HEIGHT][OCCLUSION_WIDTH];
+} OcclusionBuffer;
+
+// Frame setup, clears the buffer; like the frustum, everything is in the space of view
+void beginOcclusion(OcclusionBuffer* buffer, Mtx44 projection, Mtx view);
+
+// Adds a solid box as an occluder, it has to lie entirely inside opaque geometry
+void addOccluderBox(OcclusionBuffer* buffer, Vec3 min, Vec3 max);
+
+// Shrinks the occluded area by a pixel after the last occluder, see occlusion.c
+void finishOcclusion(OcclusionBuffer* buffer);
+
+// Whether a box is hidden behind the occluders; the second form takes the box in model space
+bool boxOccluded(const OcclusionBuffer* buffer, Vec3 min, Vec3 max);
+bool boxOccludedIn(const OcclusionBuffer* buffer, Mtx model, Vec3 min, Vec3 max);
+
+#endif
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "placement.h"
+
+// Background grid with a chained list per cell, so cells can be coarser than
+// the smallest spacing when the extent is large
+typedef struct {
+    float extent;
+    float cellSize;
+    int dim;
+    int* heads;
+    int* next;
+} PlacementGrid;
+
+static int gridCell(const PlacementGrid* grid, float v) {
+    int c = (int)floorf((v + grid->extent) / grid->cellSize);
+    if (c < 0) return 0;
+    if (c >= grid->dim) return grid->dim - 1;
+    return c;
+}
+
+static void gridAdd(PlacementGrid* grid, int index, float x, float z) {
+    int cell = gridCell(grid, z) * grid->dim + gridCell(grid, x);
+    grid->next[index] = grid->heads[cell];
+    grid->heads[cell] = index;
+}
+
+// True if a disc of radius r at (x, z) keeps its distance from every placed disc
+static bool discFits(const PlacementGrid* grid, const float* radii, const float* posX, const float* posZ,
+    float x, float z, float r, float maxRadius, float gap) {
+    float reach = r + maxRadius + gap;
+    int minX = gridCell(grid, x - reach), maxX = gridCell(grid, x + reach);
+    int minZ = gridCell(grid, z - reach), maxZ = gridCell(grid, z + reach);
+
+    for (int cz = minZ; cz <= maxZ; cz++) {
+        for (int cx = minX; cx <= maxX; cx++) {
+            for (int i = grid->heads[cz * grid->dim + cx]; i != -1; i = grid->next[i]) {
+                float dx = x - posX[i];
+                float dz = z - posZ[i];
+                float minDist = r + radii[i] + gap;
+                if (dx * dx + dz * dz < minDist * minDist) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int placeDiscs(const float* radii, int count, float extent, float gap, Rng* rng, float* outX, float* outZ) {
+    if (count <= 0) return 0;
+
+    float minRadius = FLT_MAX, maxRadius = 0.0f;
+    for (int i = 0; i < count; i++) {
+        if (radii[i] < minRadius) minRadius = radii[i];
+        if (radii[i] > maxRadius) maxRadius = radii[i];
+    }
+
+    // Classic cell size keeps one disc per cell; capped so huge oceans stay cheap
+    PlacementGrid grid;
+    grid.extent = extent;
+    grid.cellSize = fmaxf((2.0f * minRadius + gap) / sqrtf(2.0f), 2.0f * extent / PLACEMENT_MAX_CELLS);
+    grid.dim = (int)ceilf(2.0f * extent / grid.cellSize);
+    if (grid.dim < 1) grid.dim = 1;
+    grid.heads = (int*)malloc(grid.dim * grid.dim * sizeof(int));
+    grid.next = (int*)malloc(count * sizeof(int));
+    int* active = (int*)malloc(count * sizeof(int));
+    if (!grid.heads || !grid.next || !active) {
+        free(grid.heads);
+        free(grid.next);
+        free(active);
+        return 0;
+    }
+    for (int i = 0; i < grid.dim * grid.dim; i++) {
+        grid.heads[i] = -1;
+    }
+
+    // First disc anywhere it fits
+    float firstInset = extent - radii[0];
+    if (firstInset < 0.0f) {
+        free(grid.heads);
+        free(grid.next);
+        free(active);
+        return 0;
+    }
+    outX[0] = rngFloat(rng, -firstInset, firstInset);
+    outZ[0] = rngFloat(rng, -firstInset, firstInset);
+    gridAdd(&grid, 0, outX[0], outZ[0]);
+    active[0] = 0;
+    int activeCount = 1;
+    int placed = 1;
+
+    // Grow outwards from random active discs; the next disc tries the annulus
+    // between touching distance and twice that around it
+    while (placed < count && activeCount > 0) {
+        int slot = rngRange(rng, activeCount);
+        int parent = active[slot];
+        float r = radii[placed];
+        float spacing = radii[parent] + r + gap;
+        bool found = false;
+
+        for (int attempt = 0; attempt < PLACEMENT_ATTEMPTS; attempt++) {
+            float angle = rngFloat(rng, 0.0f, 2.0f * M_PI);
+            float dist = rngFloat(rng, spacing, 2.0f * spacing);
+            float x = outX[parent] + cosf(angle) * dist;
+            float z = outZ[parent] + sinf(angle) * dist;
+
+            float inset = extent - r;
+            if (x < -inset || x > inset || z < -inset || z > inset) continue;
+            if (!discFits(&grid, radii, outX, outZ, x, z, r, maxRadius, gap)) continue;
+
+            outX[placed] = x;
+            outZ[placed] = z;
+            gridAdd(&grid, placed, x, z);
+            active[activeCount++] = placed;
+            placed++;
+            found = true;
+            break;
+        }
+
+        // Nothing fits around this one any more
+        if (!found) active[slot] = active[--activeCount];
+    }
+
+    free(grid.heads);
+    free(grid.next);
+    free(active);
+    return placed;
+}
@@ -0,0 +1,16 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <gccore.h>
+#include "rng.h"
+
+// Poisson-disk placement of discs with individual radii (Bridson's algorithm
+// over a background grid). Two discs end up at least ra + rb + gap apart.
+#define PLACEMENT_ATTEMPTS   30     // Candidates tried around an active disc before it is retired
+#define PLACEMENT_MAX_CELLS  512    // Grid cells per side, coarser cells hold several discs
+
+// Places discs in index order, each one entirely inside [-extent, extent] on both axes
+// Returns how many were placed; stops at the first disc that no longer fits
+int placeDiscs(const float* radii, int count, float extent, float gap, Rng* rng, float* outX, float* outZ);
+
+#endif
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <string.h>
+#include <ogc/lwp_watchdog.h>
+#include "profiler.h"
+
+FrameProfile currentFrameProfile;
+FrameProfile lastFrameProfile;
+
+// Readout names, in enum order
+static const char* zoneNames[] = {
+    "camera occlusion",
+    "island generation",
+    "occlusion culling"
+};
+static const char* counterNames[] = {
+    "camera rays",
+    "camera cache hits",
+    "props drawn",
+    "prop cells culled",
+    "islands culled",
+    "bodies culled",
+    "water tiles culled",
+    "water quads skipped",
+    "island verts drawn",
+    "islands occluded",
+    "bodies occluded",
+    "prop cells occluded"
+};
+_Static_assert(sizeof(zoneNames) / sizeof(zoneNames[0]) == PROF_ZONE_COUNT, "a zone is missing its name");
+_Static_assert(sizeof(counterNames) / sizeof(counterNames[0]) == PROF_COUNTER_COUNT, "a counter is missing its name");
+
+// Publish the last frame's numbers and start counting a new one
+void profilerBeginFrame() {
+    lastFrameProfile = currentFrameProfile;
+    memset(&currentFrameProfile, 0, sizeof(FrameProfile));
+}
+
+u64 profileStart() {
+    return gettime();
+}
+
+void profileStop(ProfileZone zone, u64 start) {
+    currentFrameProfile.zoneTicks[zone] += gettime() - start;
+    currentFrameProfile.zoneCalls[zone]++;
+}
+
+// For work timed elsewhere (e.g. on a background thread) and reported later
+void profileAddTicks(ProfileZone zone, u64 ticks) {
+    currentFrameProfile.zoneTicks[zone] += ticks;
+    currentFrameProfile.zoneCalls[zone]++;
+}
+
+void profileCount(ProfileCounter counter, u32 amount) {
+    currentFrameProfile.counters[counter] += amount;
+}
+
+u32 profileZoneMicros(const FrameProfile* profile, ProfileZone zone) {
+    return ticks_to_microsecs(profile->zoneTicks[zone]);
+}
+
+// One frame's numbers to stdout, zones that didn't run are left out
+void printFrameProfile(const FrameProfile* profile) {
+    for (int z = 0; z < PROF_ZONE_COUNT; z++) {
+        if (!profile->zoneCalls[z]) continue;
+        printf("%-20s %6u us (%u calls)\n", zoneNames[z], profileZoneMicros(profile, z), profile->zoneCalls[z]);
+    }
+    for (int c = 0; c < PROF_COUNTER_COUNT; c++) {
+        printf("%-20s %6u\n", counterNames[c], profile->counters[c]);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <gccore.h>
+
+// Timed sections, accumulated per frame
+typedef enum {
+    PROF_CAMERA_OCCLUSION,
+    PROF_ISLAND_GENERATION,
+    PROF_OCCLUSION_CULLING,   // Occluder rasterization, the tests are spread over drawing
+    PROF_ZONE_COUNT
+} ProfileZone;
+
+// Plain per-frame counters
+typedef enum {
+    PROF_CAMERA_RAYS,
+    PROF_CAMERA_CACHE_HITS,
+    PROF_PROPS_DRAWN,
+    PROF_PROP_CELLS_CULLED,
+    PROF_ISLANDS_CULLED,      // Within draw distance but outside the view frustum
+    PROF_BODIES_CULLED,
+    PROF_WATER_TILES_CULLED,
+    PROF_WATER_QUADS_SKIPPED, // Under island footprints
+    PROF_ISLAND_VERTS_DRAWN,  // Strip vertices at the levels of detail drawn
+    PROF_ISLANDS_OCCLUDED,    // In the frustum but behind nearer islands
+    PROF_BODIES_OCCLUDED,
+    PROF_PROP_CELLS_OCCLUDED,
+    PROF_COUNTER_COUNT
+} ProfileCounter;
+
+typedef struct {
+    u64 zoneTicks[PROF_ZONE_COUNT];
+    u32 zoneCalls[PROF_ZONE_COUNT];
+    u32 counters[PROF_COUNTER_COUNT];
+} FrameProfile;
+
+extern FrameProfile currentFrameProfile;
+extern FrameProfile lastFrameProfile;  // Finished numbers from the previous frame
+
+void profilerBeginFrame();
+u64 profileStart();
+void profileStop(ProfileZone zone, u64 start);
+void profileAddTicks(ProfileZone zone, u64 ticks);
+void profileCount(ProfileCounter counter, u32 amount);
+u32 profileZoneMicros(const FrameProfile* profile, ProfileZone zone);
+void printFrameProfile(const FrameProfile* profile);
+
+#endif
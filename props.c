@@ -0,0 +1,234 @@
+#include <gccore.h>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include "props.h"
+#include "profiler.h"
+
+// Archetype meshes are plain triangle lists in prop-local space, y up, unit scale
+typedef struct {
+    float x, y, z;
+    float r, g, b;
+} PropVertex;
+
+typedef struct {
+    PropVertex vertices[PROP_MAX_MESH_VERTS];
+    int count;
+    float radius;  // Widest the mesh gets around its axis
+    float top;     // Highest vertex
+} PropMesh;
+
+static PropMesh meshes[PROP_ARCHETYPES];
+static float yawSin[256], yawCos[256];
+
+static void addVertex(PropMesh* mesh, float x, float y, float z, float r, float g, float b, float shade) {
+    if (mesh->count >= PROP_MAX_MESH_VERTS) return;
+    PropVertex* v = &mesh->vertices[mesh->count++];
+    v->x = x;
+    v->y = y;
+    v->z = z;
+    v->r = r * shade;
+    v->g = g * shade;
+    v->b = b * shade;
+}
+
+// Side faces of a cone or frustum around the y axis, ring r0 at y0 up to ring r1 at y1
+// Faces are shaded by their heading so the flat colors still read as 3D
+static void addCone(PropMesh* mesh, int sides, float r0, float y0, float r1, float y1, float r, float g, float b) {
+    for (int k = 0; k < sides; k++) {
+        float a0 = (k * 2 * M_PI) / sides;
+        float a1 = ((k + 1) * 2 * M_PI) / sides;
+        float shade = 0.7f + 0.3f * fmaxf(0.0f, cosf((a0 + a1) * 0.5f - M_PI / 4));
+        float c0 = cosf(a0), s0 = sinf(a0), c1 = cosf(a1), s1 = sinf(a1);
+
+        // Same corner order as the island quads: top ring first
+        if (r1 > 0.0f) {
+            addVertex(mesh, r1 * c0, y1, r1 * s0, r, g, b, shade);
+            addVertex(mesh, r1 * c1, y1, r1 * s1, r, g, b, shade);
+            addVertex(mesh, r0 * c1, y0, r0 * s1, r, g, b, shade);
+        }
+        if (r0 > 0.0f) {
+            addVertex(mesh, r1 * c0, y1, r1 * s0, r, g, b, shade);
+            addVertex(mesh, r0 * c1, y0, r0 * s1, r, g, b, shade);
+            addVertex(mesh, r0 * c0, y0, r0 * s0, r, g, b, shade);
+        }
+    }
+    mesh->radius = fmaxf(mesh->radius, fmaxf(r0, r1));
+    mesh->top = fmaxf(mesh->top, fmaxf(y0, y1));
+}
+
+void initPropArchetypes() {
+    memset(meshes, 0, sizeof(meshes));
+
+    // Palm: thin trunk under an umbrella of leaves
+    addCone(&meshes[PROP_PALM], 4, 0.15f, 0.0f, 0.1f, 2.4f, 0.45f, 0.3f, 0.15f);
+    addCone(&meshes[PROP_PALM], 6, 1.3f, 2.0f, 0.0f, 2.6f, 0.15f, 0.55f, 0.15f);
+
+    addCone(&meshes[PROP_BUSH], 6, 0.7f, -0.1f, 0.0f, 0.8f, 0.2f, 0.45f, 0.15f);
+
+    // Rocks sink a little into the ground so slopes don't show their base
+    addCone(&meshes[PROP_ROCK], 5, 0.8f, -0.2f, 0.45f, 0.5f, 0.5f, 0.5f, 0.48f);
+    addCone(&meshes[PROP_ROCK], 5, 0.45f, 0.5f, 0.0f, 0.7f, 0.5f, 0.5f, 0.48f);
+
+    addCone(&meshes[PROP_BASALT], 6, 0.4f, -0.2f, 0.4f, 1.8f, 0.18f, 0.12f, 0.1f);
+    addCone(&meshes[PROP_BASALT], 6, 0.4f, 1.8f, 0.0f, 1.9f, 0.3f, 0.1f, 0.05f);
+
+    addCone(&meshes[PROP_ICE_SPIRE], 4, 0.5f, -0.3f, 0.0f, 3.0f, 0.8f, 0.9f, 1.0f);
+
+    for (int i = 0; i < 256; i++) {
+        float angle = (i * 2 * M_PI) / 256;
+        yawSin[i] = sinf(angle);
+        yawCos[i] = cosf(angle);
+    }
+}
+
+float propArchetypeRadius(PropArchetype archetype) {
+    return meshes[archetype].radius;
+}
+
+void clearPropSet(PropSet* set) {
+    set->instances = NULL;
+    set->count = 0;
+    set->cells = NULL;
+}
+
+static int propCell(const PropInstance* p, float minX, float minZ, float cellW, float cellD) {
+    int i = (int)((p->x / PROP_POS_SCALE - minX) / cellW);
+    int j = (int)((p->z / PROP_POS_SCALE - minZ) / cellD);
+    if (i < 0) i = 0;
+    if (i >= PROP_CELLS) i = PROP_CELLS - 1;
+    if (j < 0) j = 0;
+    if (j >= PROP_CELLS) j = PROP_CELLS - 1;
+    return j * PROP_CELLS + i;
+}
+
+// Counting sort on (cell, archetype), so every cell ends up with one run per archetype
+bool buildPropSet(PropSet* set, Arena* arena, const PropInstance* instances, const u8* archetypes,
+    int count, float minX, float minZ, float maxX, float maxZ) {
+    clearPropSet(set);
+    int cellCount = PROP_CELLS * PROP_CELLS;
+    PropCell* cells = (PropCell*)arenaAlloc(arena, cellCount * sizeof(PropCell));
+    PropInstance* sorted = (PropInstance*)arenaAlloc(arena, (count ? count : 1) * sizeof(PropInstance));
+    if (!cells || !sorted) return false;
+
+    float cellW = fmaxf((maxX - minX) / PROP_CELLS, 1e-3f);
+    float cellD = fmaxf((maxZ - minZ) / PROP_CELLS, 1e-3f);
+
+    int offsets[PROP_CELLS * PROP_CELLS * PROP_ARCHETYPES + 1];
+    memset(offsets, 0, sizeof(offsets));
+    for (int n = 0; n < count; n++) {
+        int key = propCell(&instances[n], minX, minZ, cellW, cellD) * PROP_ARCHETYPES + archetypes[n];
+        offsets[key + 1]++;
+    }
+    for (int k = 0; k < cellCount * PROP_ARCHETYPES; k++) {
+        offsets[k + 1] += offsets[k];
+    }
+
+    for (int c = 0; c < cellCount; c++) {
+        PropCell* cell = &cells[c];
+        cell->minX = minX + (c % PROP_CELLS) * cellW;
+        cell->minZ = minZ + (c / PROP_CELLS) * cellD;
+        cell->maxX = cell->minX + cellW;
+        cell->maxZ = cell->minZ + cellD;
+        cell->minY = FLT_MAX;
+        cell->maxY = -FLT_MAX;
+        for (int a = 0; a <= PROP_ARCHETYPES; a++) {
+            cell->start[a] = (u16)offsets[c * PROP_ARCHETYPES + a];
+        }
+    }
+
+    // Place each instance and grow its cell to cover the whole prop
+    for (int n = 0; n < count; n++) {
+        const PropInstance* p = &instances[n];
+        int c = propCell(p, minX, minZ, cellW, cellD);
+        int key = c * PROP_ARCHETYPES + archetypes[n];
+        sorted[offsets[key]++] = *p;
+
+        const PropMesh* mesh = &meshes[archetypes[n]];
+        float scale = p->scale / PROP_SCALE_STEP;
+        float x = p->x / PROP_POS_SCALE, y = p->y / PROP_POS_SCALE, z = p->z / PROP_POS_SCALE;
+        PropCell* cell = &cells[c];
+        cell->minX = fminf(cell->minX, x - mesh->radius * scale);
+        cell->maxX = fmaxf(cell->maxX, x + mesh->radius * scale);
+        cell->minZ = fminf(cell->minZ, z - mesh->radius * scale);
+        cell->maxZ = fmaxf(cell->maxZ, z + mesh->radius * scale);
+        cell->minY = fminf(cell->minY, y - 0.5f * scale);
+        cell->maxY = fmaxf(cell->maxY, y + mesh->top * scale);
+    }
+
+    set->instances = sorted;
+    set->count = count;
+    set->cells = cells;
+    return true;
+}
+
+// One instance of an archetype, rotated, scaled and moved on the CPU
+static void emitProp(const PropMesh* mesh, const PropInstance* p) {
+    float scale = p->scale / PROP_SCALE_STEP;
+    float c = yawCos[p->yaw] * scale;
+    float s = yawSin[p->yaw] * scale;
+    float x = p->x / PROP_POS_SCALE, y = p->y / PROP_POS_SCALE, z = p->z / PROP_POS_SCALE;
+
+    for (int i = 0; i < mesh->count; i++) {
+        const PropVertex* v = &mesh->vertices[i];
+        GX_Position3f32(x + v->x * c - v->z * s, y + v->y * scale, z + v->x * s + v->z * c);
+        GX_Color3f32(v->r, v->g, v->b);
+    }
+}
+
+// Cells out of range or hidden are dropped first, then every archetype goes out as one
+// primitive over all the cells that are left (split only when it would pass GX_Begin's
+// vertex limit)
+void drawPropSet(const PropSet* set, float viewX, float viewZ, float range,
+    const OcclusionBuffer* occlusion, Mtx model) {
+    if (!set->cells || set->count == 0) return;
+
+    int visible[PROP_CELLS * PROP_CELLS];
+    int visibleCount = 0;
+    for (int c = 0; c < PROP_CELLS * PROP_CELLS; c++) {
+        const PropCell* cell = &set->cells[c];
+        if (cell->start[0] == cell->start[PROP_ARCHETYPES]) continue;
+
+        float dx = fmaxf(fmaxf(cell->minX - viewX, 0.0f), viewX - cell->maxX);
+        float dz = fmaxf(fmaxf(cell->minZ - viewZ, 0.0f), viewZ - cell->maxZ);
+        if (dx * dx + dz * dz > range * range) {
+            profileCount(PROF_PROP_CELLS_CULLED, 1);
+            continue;
+        }
+        if (occlusion) {
+            Vec3 min = { cell->minX, cell->minY, cell->minZ };
+            Vec3 max = { cell->maxX, cell->maxY, cell->maxZ };
+            if (boxOccludedIn(occlusion, model, min, max)) {
+                profileCount(PROF_PROP_CELLS_OCCLUDED, 1);
+                continue;
+            }
+        }
+        visible[visibleCount++] = c;
+    }
+
+    for (int a = 0; a < PROP_ARCHETYPES; a++) {
+        const PropMesh* mesh = &meshes[a];
+        int remaining = 0;
+        for (int v = 0; v < visibleCount; v++) {
+            const PropCell* cell = &set->cells[visible[v]];
+            remaining += cell->start[a + 1] - cell->start[a];
+        }
+        if (remaining == 0 || mesh->count == 0) continue;
+        profileCount(PROF_PROPS_DRAWN, remaining);
+
+        int perBatch = 0xFFFF / mesh->count;
+        int inBatch = 0;
+        for (int v = 0; v < visibleCount; v++) {
+            const PropCell* cell = &set->cells[visible[v]];
+            for (int i = cell->start[a]; i < cell->start[a + 1]; i++) {
+                if (inBatch == 0) {
+                    inBatch = remaining < perBatch ? remaining : perBatch;
+                    remaining -= inBatch;
+                    GX_Begin(GX_TRIANGLES, GX_VTXFMT0, inBatch * mesh->count);
+                }
+                emitProp(mesh, &set->instances[i]);
+                if (--inBatch == 0) GX_End();
+            }
+        }
+    }
+}
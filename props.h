@@ -0,0 +1,61 @@
+#ifndef PROPS_H
+#define PROPS_H
+
+#include "common.h"
+#include "arena.h"
+#include "occlusion.h"
+
+// Trees, rocks and ice scattered over the islands, drawn in per-archetype batches
+#define PROP_CELLS           4       // Cells per side of an island's prop grid, the unit of culling
+#define PROP_DENSITY         0.1f    // Scatter attempts per square unit of island surface
+#define PROP_MAX_PER_ISLAND  1024
+#define PROP_DRAW_DISTANCE   70.0f   // Props are small, they stop well before the islands do
+#define PROP_POS_SCALE       64.0f   // Fixed-point steps per unit of instance position
+#define PROP_SCALE_STEP      64.0f   // Fixed-point steps per unit of instance scale
+#define PROP_MAX_MESH_VERTS  96      // Triangle list vertices of the largest archetype
+
+typedef enum {
+    PROP_PALM,
+    PROP_BUSH,
+    PROP_ROCK,
+    PROP_BASALT,
+    PROP_ICE_SPIRE,
+    PROP_ARCHETYPES
+} PropArchetype;
+
+// 8 bytes; the archetype is implied by where the instance sits in its cell
+typedef struct {
+    s16 x, y, z;  // Same space as the island mesh (XZ relative to the island)
+    u8 yaw;       // 256 steps per turn
+    u8 scale;     // PROP_SCALE_STEP steps per unit
+} PropInstance;
+
+// A cell's instances are sorted by archetype: archetype a owns [start[a], start[a + 1])
+typedef struct {
+    float minX, minY, minZ;
+    float maxX, maxY, maxZ;
+    u16 start[PROP_ARCHETYPES + 1];
+} PropCell;
+
+typedef struct {
+    PropInstance* instances;
+    int count;
+    PropCell* cells;  // PROP_CELLS * PROP_CELLS, NULL until the island is scattered
+} PropSet;
+
+// Archetype meshes, once at startup before anything is drawn
+void initPropArchetypes();
+float propArchetypeRadius(PropArchetype archetype);
+
+// Bins scattered instances into cells over the given XZ rectangle; everything lives in arena
+bool buildPropSet(PropSet* set, Arena* arena, const PropInstance* instances, const u8* archetypes,
+    int count, float minX, float minZ, float maxX, float maxZ);
+void clearPropSet(PropSet* set);
+
+// Draws the cells within range of the view position (both in the instances' space)
+// with the island's matrix loaded; model takes that space to the occlusion buffer's,
+// which may be NULL
+void drawPropSet(const PropSet* set, float viewX, float viewZ, float range,
+    const OcclusionBuffer* occlusion, Mtx model);
+
+#endif
@@ -0,0 +1,50 @@
+#include "rng.h"
+
+void rngSeed(Rng* rng, u64 seed, u64 stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1u;  // Increment must be odd
+    rngNext(rng);
+    rng->state += seed;
+    rngNext(rng);
+}
+
+// PCG32 (XSH RR): 64-bit LCG state, 32-bit permuted output
+u32 rngNext(Rng* rng) {
+    u64 old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    u32 xorshifted = (u32)(((old >> 18u) ^ old) >> 27u);
+    u32 rot = (u32)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// Random float between min and max
+float rngFloat(Rng* rng, float min, float max) {
+    // Top 24 bits give an exact float in [0, 1)
+    float t = (rngNext(rng) >> 8) * (1.0f / 16777216.0f);
+    return min + (max - min) * t;
+}
+
+// Random integer in [0, n)
+int rngRange(Rng* rng, int n) {
+    if (n <= 0) return 0;
+    return (int)(((u64)rngNext(rng) * (u64)n) >> 32);
+}
+
+// SplitMix64 finalizer, scrambles a 64-bit value
+u64 rngMix(u64 x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Seed for the index-th island of a world
+u64 rngDeriveSeed(u64 worldSeed, u32 index) {
+    return rngMix(worldSeed ^ rngMix((u64)index + 1));
+}
+
+// Seed of the ocean chunk at (cx, cz), independent of the order chunks are visited in
+u64 rngChunkSeed(u64 worldSeed, int cx, int cz) {
+    u64 coord = ((u64)(u32)cx << 32) | (u32)cz;
+    return rngMix(worldSeed ^ rngMix(coord ^ 0x9E3779B97F4A7C15ULL));
+}
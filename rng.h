@@ -0,0 +1,28 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <gccore.h>
+
+// Small PCG32 generator so every island can own its own random stream
+typedef struct {
+    u64 state;
+    u64 inc;
+} Rng;
+
+// Stream ids, so one island seed can drive independent sequences
+#define RNG_STREAM_SHAPE      1
+#define RNG_STREAM_SIZE       2
+#define RNG_STREAM_BODIES     3
+#define RNG_STREAM_PLACEMENT  4
+#define RNG_STREAM_GENERATOR  5
+#define RNG_STREAM_PROPS      6
+
+void rngSeed(Rng* rng, u64 seed, u64 stream);
+u32 rngNext(Rng* rng);
+float rngFloat(Rng* rng, float min, float max);
+int rngRange(Rng* rng, int n);
+u64 rngMix(u64 x);
+u64 rngDeriveSeed(u64 worldSeed, u32 index);
+u64 rngChunkSeed(u64 worldSeed, int cx, int cz);
+
+#endif
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+#include "islandCache.h"
+
+// Compact session snapshot: the world is just its seed and chunk settings
+// (chunks regenerate deterministically), the live entity state is stored as-is,
+// relative to the floating origin chunk saved with it
+typedef struct {
+    u32 magic;
+    u32 version;
+    u64 worldSeed;
+    ChunkSettings chunkSettings;
+    s32 originCx, originCz;
+    u32 bodyCount;
+    float time;
+    u32 isPlayerActive;
+} SnapshotHeader;
+
+bool saveSnapshot(const IslandManager* islands, const BodyManager* bodies, const Boat* boat,
+    const Player* player, const Camera* camera, bool isPlayerActive, float time) {
+    size_t size = sizeof(SnapshotHeader) +
+        sizeof(Boat) + sizeof(Player) + sizeof(Camera) + bodies->count * sizeof(Body);
+
+    u8* buffer = (u8*)malloc(size);
+    if (!buffer) return false;
+    u8* cursor = buffer;
+
+    SnapshotHeader header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .worldSeed = islands->worldSeed,
+        .chunkSettings = islands->settings,
+        .originCx = islands->originCx,
+        .originCz = islands->originCz,
+        .bodyCount = bodies->count,
+        .time = time,
+        .isPlayerActive = isPlayerActive
+    };
+    memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+
+    memcpy(cursor, boat, sizeof(Boat));
+    cursor += sizeof(Boat);
+    memcpy(cursor, player, sizeof(Player));
+    cursor += sizeof(Player);
+    memcpy(cursor, camera, sizeof(Camera));
+    cursor += sizeof(Camera);
+    memcpy(cursor, bodies->bodies, bodies->count * sizeof(Body));
+
+    mkdir(ISLAND_CACHE_DIR, 0777);
+
+    bool ok = false;
+    FILE* file = fopen(SNAPSHOT_PATH, "wb");
+    if (file) {
+        ok = fwrite(buffer, 1, size, file) == size;
+        ok = (fclose(file) == 0) && ok;
+    }
+
+    free(buffer);
+    return ok;
+}
+
+// Settings a snapshot brings along drive every chunk generated from then on, so anything
+// the generator couldn't have been given means starting a fresh world instead
+static bool chunkSettingsValid(const ChunkSettings* settings) {
+    return isfinite(settings->chunkSize) &&
+        settings->chunkSize >= CHUNK_SIZE / 8.0f && settings->chunkSize <= CHUNK_SIZE * 8.0f &&
+        settings->islandsPerChunk >= 0 && settings->islandsPerChunk <= ISLAND_CACHE_MAX_ISLANDS &&
+        settings->noiseIslandPercent >= 0 && settings->noiseIslandPercent <= 100 &&
+        settings->instancedIslandPercent >= 0 && settings->instancedIslandPercent <= 100 &&
+        settings->islandSegments == clampIslandSegments(settings->islandSegments) &&
+        settings->heightmapResolution == clampIslandSegments(settings->heightmapResolution);
+}
+
+// Restores the session; chunks around the camera are loaded and the islands
+// near it built right away, the rest streams in as usual
+bool loadSnapshot(IslandManager* islands, BodyManager* bodies, Boat* boat,
+    Player* player, Camera* camera, bool* isPlayerActive, float* time) {
+    FILE* file = fopen(SNAPSHOT_PATH, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u8* buffer = (size > (long)sizeof(SnapshotHeader)) ? (u8*)malloc(size) : NULL;
+    bool readOk = buffer && fread(buffer, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!readOk) {
+        free(buffer);
+        return false;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    size_t expected = sizeof(SnapshotHeader) +
+        sizeof(Boat) + sizeof(Player) + sizeof(Camera) + header.bodyCount * sizeof(Body);
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        !chunkSettingsValid(&header.chunkSettings) || header.bodyCount > MAX_BODIES ||
+        expected != (size_t)size) {
+        free(buffer);
+        return false;
+    }
+
+    const u8* cursor = buffer + sizeof(header);
+
+    memcpy(boat, cursor, sizeof(Boat));
+    cursor += sizeof(Boat);
+    memcpy(player, cursor, sizeof(Player));
+    cursor += sizeof(Player);
+    memcpy(camera, cursor, sizeof(Camera));
+    cursor += sizeof(Camera);
+    camera->cacheValid = false;
+
+    bodies->count = header.bodyCount;
+    memcpy(bodies->bodies, cursor, header.bodyCount * sizeof(Body));
+
+    *isPlayerActive = header.isPlayerActive != 0;
+    *time = header.time;
+
+    initIslandManager(islands, header.worldSeed);
+    islands->settings = header.chunkSettings;
+    islands->originCx = header.originCx;
+    islands->originCz = header.originCz;
+
+    Vec3 cameraPos = { camera->position.x, camera->position.y, camera->position.z };
+    regenerateIslands(islands, cameraPos);
+
+    free(buffer);
+    return true;
+}
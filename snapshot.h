@@ -0,0 +1,19 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "manager.h"
+#include "bodyManager.h"
+#include "boat.h"
+#include "player.h"
+#include "camera.h"
+
+#define SNAPSHOT_PATH           "sd:/island_game/snapshot.bin"
+#define SNAPSHOT_MAGIC          0x49534E50  // "ISNP"
+#define SNAPSHOT_VERSION        6
+
+bool saveSnapshot(const IslandManager* islands, const BodyManager* bodies, const Boat* boat,
+    const Player* player, const Camera* camera, bool isPlayerActive, float time);
+bool loadSnapshot(IslandManager* islands, BodyManager* bodies, Boat* boat,
+    Player* player, Camera* camera, bool* isPlayerActive, float* time);
+
+#endif
@@ -1,30 +1,134 @@
 #include <gccore.h>
 #include <math.h>
+#include <stdlib.h>
+#include <malloc.h>
 #include "common.h"
+#include "water.h"
+#include "profiler.h"
 
-void drawWater(float time) {
-    // Original water drawing code exactly as you wrote it
-    GX_Begin(GX_QUADS, GX_VTXFMT0, (WATER_SIZE - 1) * (WATER_SIZE - 1) * 4);
-
-    for (int i = 0; i < WATER_SIZE - 1; i++) {
-        for (int j = 0; j < WATER_SIZE - 1; j++) {
-            f32 x0 = i - WATER_SIZE / 2;
-            f32 z0 = j - WATER_SIZE / 2;
-            f32 x1 = i + 1 - WATER_SIZE / 2;
-            f32 z1 = j - WATER_SIZE / 2;
-            f32 x2 = i + 1 - WATER_SIZE / 2;
-            f32 z2 = j + 1 - WATER_SIZE / 2;
-            f32 x3 = i - WATER_SIZE / 2;
-            f32 z3 = j + 1 - WATER_SIZE / 2;
-
-            f32 y0 = sinf((x0 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE + cosf((z0 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE;
-            f32 y1 = sinf((x1 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE + cosf((z1 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE;
-            f32 y2 = sinf((x2 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE + cosf((z2 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE;
-            f32 y3 = sinf((x3 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE + cosf((z3 + time) * WAVE_FREQUENCY) * WAVE_AMPLITUDE;
-
-            float waveHeight = (y0 + y1 + y2 + y3) / 4.0f;
-            float r = 0.0f, g = 0.0f, b = 0.0f;
+// Wave phase of the floating origin, so local positions give the same waves
+// as world ones. Worked out in double and wrapped, the world coordinate
+// itself never goes through a float
+static float wavePhaseX = 0.0f;
+static float wavePhaseZ = 0.0f;
 
+void setWaveOrigin(double originX, double originZ) {
+    wavePhaseX = (float)fmod(originX * WAVE_FREQUENCY, 2.0 * M_PI);
+    wavePhaseZ = (float)fmod(originZ * WAVE_FREQUENCY, 2.0 * M_PI);
+}
+
+// Water surface height at local (x, z)
+float waveHeightAt(float x, float z, float time) {
+    return sinf((x + time) * WAVE_FREQUENCY + wavePhaseX) * WAVE_AMPLITUDE +
+        cosf((z + time) * WAVE_FREQUENCY + wavePhaseZ) * WAVE_AMPLITUDE;
+}
+
+// Clipmap: level L is a square grid with spacing 1 << L around the camera. Every level
+// has the same static x and z grid steps (scaled by its matrix) and its own y and colors
+// Positions are s16 with WATER_POS_FRAC fraction bits, both arrays are read by index
+typedef struct {
+    s16* positions;  // x, y, z per vertex, WATER_GRID_SIZE per row along x
+    u8* colors;      // RGB8 per vertex
+    f32 originX, originZ;  // Where vertex (0, 0) is this frame
+    float spacing;
+    int holeMinI, holeMinJ, holeSize;  // Square of quads the level inside covers
+} WaterLevel;
+
+#define WATER_VERTICES  (WATER_GRID_SIZE * WATER_GRID_SIZE)
+
+static WaterLevel waterLevels[WATER_LEVELS];
+
+void initWater() {
+    for (int l = 0; l < WATER_LEVELS; l++) {
+        WaterLevel* level = &waterLevels[l];
+        level->positions = (s16*)memalign(32, WATER_VERTICES * 3 * sizeof(s16));
+        level->colors = (u8*)memalign(32, WATER_VERTICES * 3);
+        if (!level->positions || !level->colors) {
+            shutdownWater();
+            return;
+        }
+        level->spacing = (float)(1 << l);
+
+        for (int j = 0; j < WATER_GRID_SIZE; j++) {
+            for (int i = 0; i < WATER_GRID_SIZE; i++) {
+                s16* p = &level->positions[(j * WATER_GRID_SIZE + i) * 3];
+                p[0] = (s16)(i << WATER_POS_FRAC);
+                p[1] = 0;
+                p[2] = (s16)(j << WATER_POS_FRAC);
+            }
+        }
+    }
+
+    GX_SetVtxAttrFmt(GX_VTXFMT2, GX_VA_POS, GX_POS_XYZ, GX_S16, WATER_POS_FRAC);
+    GX_SetVtxAttrFmt(GX_VTXFMT2, GX_VA_CLR0, GX_CLR_RGB, GX_RGB8, 0);
+}
+
+void shutdownWater() {
+    for (int l = 0; l < WATER_LEVELS; l++) {
+        free(waterLevels[l].positions);
+        free(waterLevels[l].colors);
+        waterLevels[l].positions = NULL;
+        waterLevels[l].colors = NULL;
+    }
+}
+
+// Each level snaps to twice its spacing, the spacing of the level outside it. Vertices
+// then stay on fixed world points (the waves don't swim), every level's edge falls on
+// whole quads of the next one, and the inner level always sits 8 or 9 quads in
+static void placeWaterLevels(float centerX, float centerZ) {
+    for (int l = 0; l < WATER_LEVELS; l++) {
+        WaterLevel* level = &waterLevels[l];
+        float snap = level->spacing * 2.0f;
+        level->originX = floorf(centerX / snap) * snap - (WATER_GRID_QUADS / 2) * level->spacing;
+        level->originZ = floorf(centerZ / snap) * snap - (WATER_GRID_QUADS / 2) * level->spacing;
+
+        level->holeSize = 0;
+        if (l > 0) {
+            const WaterLevel* inner = &waterLevels[l - 1];
+            level->holeMinI = (int)((inner->originX - level->originX) / level->spacing);
+            level->holeMinJ = (int)((inner->originZ - level->originZ) / level->spacing);
+            level->holeSize = WATER_GRID_QUADS / 2;
+        }
+    }
+}
+
+static u8 colorByte(float c) {
+    return (u8)(fminf(1.0f, fmaxf(0.0f, c)) * 255.0f);
+}
+
+// Wave terms along one side of a level. The edge copy has every odd vertex moved to
+// halfway between its neighbours, which is where the next level's coarser edge runs,
+// so the two meet without cracks
+static void waveTerms(const WaterLevel* level, float origin, float time, float phase, bool useSin,
+    float* terms, float* edgeTerms) {
+    for (int n = 0; n < WATER_GRID_SIZE; n++) {
+        float angle = (origin + n * level->spacing + time) * WAVE_FREQUENCY + phase;
+        terms[n] = (useSin ? sinf(angle) : cosf(angle)) * WAVE_AMPLITUDE;
+    }
+    for (int n = 0; n < WATER_GRID_SIZE; n++) {
+        edgeTerms[n] = (n & 1) ? (terms[n - 1] + terms[n + 1]) * 0.5f : terms[n];
+    }
+}
+
+// Heights and colors of one level. waveHeightAt is a sine along x plus a cosine along z,
+// so one row of sines and one column of cosines cover every vertex
+static void updateWaterLevel(WaterLevel* level, float time, bool stitched) {
+    float waveX[WATER_GRID_SIZE], waveZ[WATER_GRID_SIZE];
+    float edgeX[WATER_GRID_SIZE], edgeZ[WATER_GRID_SIZE];
+    waveTerms(level, level->originX, time, wavePhaseX, true, waveX, edgeX);
+    waveTerms(level, level->originZ, time, wavePhaseZ, false, waveZ, edgeZ);
+    float timeShift = sinf(time * 0.1f);
+
+    const int last = WATER_GRID_SIZE - 1;
+    for (int j = 0; j < WATER_GRID_SIZE; j++) {
+        const float* rowX = (stitched && (j == 0 || j == last)) ? edgeX : waveX;
+        for (int i = 0; i < WATER_GRID_SIZE; i++) {
+            int v = j * WATER_GRID_SIZE + i;
+            float z = (stitched && (i == 0 || i == last)) ? edgeZ[j] : waveZ[j];
+            float waveHeight = rowX[i] + z;
+            level->positions[v * 3 + 1] = (s16)lrintf(waveHeight * (1 << WATER_POS_FRAC));
+
+            float r, g, b;
             if (waveHeight > -1.0f) {
                 r = 0.05f + 0.2f * waveHeight;
                 g = 0.1f + 0.2f * waveHeight;
@@ -35,26 +139,122 @@ void drawWater(float time) {
                 g = 0.0f;
                 b = 0.7f;
             }
-
-            float timeShift = sinf(time * 0.1f);
-            r += 0.1f * timeShift;
-            g += 0.05f * timeShift;
-            b += 0.1f * timeShift;
-
-            r = fminf(1.0f, fmaxf(0.0f, r));
-            g = fminf(1.0f, fmaxf(0.0f, g));
-            b = fminf(1.0f, fmaxf(0.0f, b));
-
-            GX_Position3f32(x0, y0, z0);
-            GX_Color3f32(r, g, b);
-            GX_Position3f32(x1, y1, z1);
-            GX_Color3f32(r, g, b);
-            GX_Position3f32(x2, y2, z2);
-            GX_Color3f32(r, g, b);
-            GX_Position3f32(x3, y3, z3);
-            GX_Color3f32(r, g, b);
+            level->colors[v * 3] = colorByte(r + 0.1f * timeShift);
+            level->colors[v * 3 + 1] = colorByte(g + 0.05f * timeShift);
+            level->colors[v * 3 + 2] = colorByte(b + 0.1f * timeShift);
         }
     }
 
+    // The previous frame finished with GX_DrawDone, so the GP is no longer reading these
+    DCFlushRange(level->positions, WATER_VERTICES * 3 * sizeof(s16));
+    DCFlushRange(level->colors, WATER_VERTICES * 3);
+    GX_InvVtxCache();
+}
+
+// Quads [i0, i1) of row j as one strip
+static void emitWaterStrip(int j, int i0, int i1) {
+    if (i1 <= i0) return;
+    GX_Begin(GX_TRIANGLESTRIP, GX_VTXFMT2, (i1 - i0 + 1) * 2);
+    for (int i = i0; i <= i1; i++) {
+        u16 row = (u16)(j * WATER_GRID_SIZE + i);
+        u16 nextRow = (u16)(row + WATER_GRID_SIZE);
+        GX_Position1x16(row);
+        GX_Color1x16(row);
+        GX_Position1x16(nextRow);
+        GX_Color1x16(nextRow);
+    }
     GX_End();
-}
\ No newline at end of file
+}
+
+// Length of the overlap of [a0, a1) and [b0, b1)
+static int spanOverlap(int a0, int a1, int b0, int b1) {
+    int start = a0 > b0 ? a0 : b0, end = a1 < b1 ? a1 : b1;
+    return end > start ? end - start : 0;
+}
+
+// Tiles of a level outside its hole and inside the frustum, one strip per quad row and
+// side of the hole
+
+static void drawWaterLevel(WaterLevel* level, float time, bool stitched, Mtx modelview, const Frustum* frustum,
+    IslandManager* islands) {
+    // Spheres around the tiles, flat at y = 0 plus the highest a wave gets
+    float half = WATER_TILE_QUADS * 0.5f * level->spacing;
+    float radius = sqrtf(2.0f * half * half + 4.0f * WAVE_AMPLITUDE * WAVE_AMPLITUDE);
+    SphereBatch spheres;
+    u8 tiles[WATER_TILES * WATER_TILES];
+    spheres.count = 0;
+    for (int t = 0; t < WATER_TILES * WATER_TILES; t++) {
+        int i0 = (t % WATER_TILES) * WATER_TILE_QUADS, j0 = (t / WATER_TILES) * WATER_TILE_QUADS;
+        bool inHole = i0 >= level->holeMinI && i0 + WATER_TILE_QUADS <= level->holeMinI + level->holeSize &&
+            j0 >= level->holeMinJ && j0 + WATER_TILE_QUADS <= level->holeMinJ + level->holeSize;
+        if (inHole) continue;
+
+        tiles[spheres.count] = (u8)t;
+        addSphere(&spheres, level->originX + i0 * level->spacing + half, 0.0f,
+            level->originZ + j0 * level->spacing + half, radius);
+    }
+    u8 visible[FRUSTUM_BATCH];
+    int count = cullSphereBatch(frustum, &spheres, visible);
+    profileCount(PROF_WATER_TILES_CULLED, spheres.count - count);
+
+    // Then the tiles that sit entirely on an island, counted by the quads they'd have drawn
+    int holeEndI = level->holeMinI + level->holeSize, holeEndJ = level->holeMinJ + level->holeSize;
+    int kept = 0;
+    for (int v = 0; v < count; v++) {
+        int t = tiles[visible[v]];
+        int i0 = (t % WATER_TILES) * WATER_TILE_QUADS, j0 = (t / WATER_TILES) * WATER_TILE_QUADS;
+        float minX = level->originX + i0 * level->spacing, minZ = level->originZ + j0 * level->spacing;
+        float size = WATER_TILE_QUADS * level->spacing;
+        if (islandsCoverRect(islands, minX, minZ, minX + size, minZ + size)) {
+            int holeW = spanOverlap(i0, i0 + WATER_TILE_QUADS, level->holeMinI, holeEndI);
+            int holeD = spanOverlap(j0, j0 + WATER_TILE_QUADS, level->holeMinJ, holeEndJ);
+            profileCount(PROF_WATER_QUADS_SKIPPED, WATER_TILE_QUADS * WATER_TILE_QUADS - holeW * holeD);
+            continue;
+        }
+        visible[kept++] = visible[v];
+    }
+    count = kept;
+    if (count == 0) return;
+
+    updateWaterLevel(level, time, stitched);
+
+    Mtx placed, levelView;
+    guMtxScale(placed, level->spacing, 1.0f, level->spacing);
+    guMtxTransApply(placed, placed, level->originX, 0.0f, level->originZ);
+    guMtxConcat(modelview, placed, levelView);
+    GX_LoadPosMtxImm(levelView, GX_PNMTX0);
+    GX_SetArray(GX_VA_POS, level->positions, 3 * sizeof(s16));
+    GX_SetArray(GX_VA_CLR0, level->colors, 3);
+
+    for (int v = 0; v < count; v++) {
+        int t = tiles[visible[v]];
+        int i0 = (t % WATER_TILES) * WATER_TILE_QUADS, j0 = (t / WATER_TILES) * WATER_TILE_QUADS;
+        int i1 = i0 + WATER_TILE_QUADS;
+        for (int j = j0; j < j0 + WATER_TILE_QUADS; j++) {
+            if (j < level->holeMinJ || j >= holeEndJ || i1 <= level->holeMinI || i0 >= holeEndI) {
+                emitWaterStrip(j, i0, i1);
+            } else {
+                emitWaterStrip(j, i0, level->holeMinI);
+                emitWaterStrip(j, holeEndI, i1);
+            }
+        }
+    }
+}
+
+// The clipmap follows (centerX, centerZ), finest level in the middle; every level but the
+// outermost bends its edge onto the next one's
+void drawWater(float time, float centerX, float centerZ, Mtx modelview, const Frustum* frustum, IslandManager* islands) {
+    if (!waterLevels[WATER_LEVELS - 1].positions) return;
+
+    placeWaterLevels(centerX, centerZ);
+
+    GX_SetVtxDesc(GX_VA_POS, GX_INDEX16);
+    GX_SetVtxDesc(GX_VA_CLR0, GX_INDEX16);
+    for (int l = 0; l < WATER_LEVELS; l++) {
+        drawWaterLevel(&waterLevels[l], time, l + 1 < WATER_LEVELS, modelview, frustum, islands);
+    }
+
+    GX_SetVtxDesc(GX_VA_POS, GX_DIRECT);
+    GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+    GX_LoadPosMtxImm(modelview, GX_PNMTX0);
+}
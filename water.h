@@ -1,6 +1,28 @@
 #ifndef WATER_H
 #define WATER_H
 
-void drawWater(float time);
+#include "common.h"
+#include "frustum.h"
+#include "manager.h"
+
+// Ocean clipmap: nested square grids around the camera, each with twice the spacing of
+// the one inside it. The outermost reaches 256 units out, past the far plane
+#define WATER_LEVELS      5
+#define WATER_GRID_QUADS  32  // Per side of every level, divisible by 4 for the nesting
+#define WATER_GRID_SIZE   (WATER_GRID_QUADS + 1)
+#define WATER_POS_FRAC    8   // Fraction bits of the s16 grid positions
+
+// Culling units of a level: WATER_TILES per side of WATER_TILE_QUADS quads each
+#define WATER_TILE_QUADS  8
+#define WATER_TILES       (WATER_GRID_QUADS / WATER_TILE_QUADS)
+
+// Grid arrays and vertex format (GX_VTXFMT2), once at startup
+void initWater();
+void shutdownWater();
+
+void setWaveOrigin(double originX, double originZ);
+float waveHeightAt(float x, float z, float time);
+// Tiles the islands hide completely are left out; islands may be NULL
+void drawWater(float time, float centerX, float centerZ, Mtx modelview, const Frustum* frustum, IslandManager* islands);
 
 #endif
\ No newline at end of file
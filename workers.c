@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <malloc.h>
+#include "workers.h"
+
+// Fixed-size pool of LWP threads working through one index range at a time
+typedef struct {
+    lwp_t threads[WORKER_COUNT];
+    u8* stacks[WORKER_COUNT];
+    mutex_t lock;
+    mutex_t submitLock;  // Only one parallel-for runs at a time
+    lwp_t owner;         // Thread that started the pool, the only one that hands it work
+    cond_t workReady;
+    cond_t workDone;
+
+    WorkerJobFn job;
+    void* context;
+    int count;
+    int nextIndex;
+    int remaining;
+    bool quit;
+    bool started;
+} WorkerPool;
+
+static WorkerPool pool;
+
+// Take the next index and run it, returns false when the range is used up
+static bool runNextJob() {
+    LWP_MutexLock(pool.lock);
+    if (pool.nextIndex >= pool.count) {
+        LWP_MutexUnlock(pool.lock);
+        return false;
+    }
+    int index = pool.nextIndex++;
+    WorkerJobFn job = pool.job;
+    void* context = pool.context;
+    LWP_MutexUnlock(pool.lock);
+
+    job(context, index);
+
+    LWP_MutexLock(pool.lock);
+    if (--pool.remaining == 0) {
+        LWP_CondSignal(pool.workDone);
+    }
+    LWP_MutexUnlock(pool.lock);
+    return true;
+}
+
+static void* workerMain(void* arg) {
+    while (1) {
+        LWP_MutexLock(pool.lock);
+        while (!pool.quit && pool.nextIndex >= pool.count) {
+            LWP_CondWait(pool.workReady, pool.lock);
+        }
+        bool quit = pool.quit;
+        LWP_MutexUnlock(pool.lock);
+        if (quit) break;
+
+        while (runNextJob()) {}
+    }
+    return NULL;
+}
+
+void initWorkerPool() {
+    if (pool.started) return;
+
+    LWP_MutexInit(&pool.lock, false);
+    LWP_MutexInit(&pool.submitLock, false);
+    LWP_CondInit(&pool.workReady);
+    LWP_CondInit(&pool.workDone);
+    pool.count = 0;
+    pool.nextIndex = 0;
+    pool.remaining = 0;
+    pool.quit = false;
+    pool.owner = LWP_GetSelf();
+
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        pool.stacks[i] = (u8*)memalign(32, WORKER_STACK_SIZE);
+        LWP_CreateThread(&pool.threads[i], workerMain, NULL, pool.stacks[i], WORKER_STACK_SIZE, WORKER_PRIORITY);
+    }
+    pool.started = true;
+}
+
+// Run job(context, i) for every i in [0, count) and wait until all are done
+// Jobs finish in any order, so each index must only write its own output
+// Other threads (the world builder) run their jobs inline at their own priority: handing
+// them to the workers would run background work at WORKER_PRIORITY, and the main loop
+// would wait on submitLock behind a low-priority holder
+void workerParallelFor(WorkerJobFn job, void* context, int count) {
+    if (count <= 0) return;
+
+    if (!pool.started || LWP_GetSelf() != pool.owner) {
+        for (int i = 0; i < count; i++) job(context, i);
+        return;
+    }
+
+    LWP_MutexLock(pool.submitLock);
+
+    LWP_MutexLock(pool.lock);
+    pool.job = job;
+    pool.context = context;
+    pool.count = count;
+    pool.nextIndex = 0;
+    pool.remaining = count;
+    LWP_CondBroadcast(pool.workReady);
+    LWP_MutexUnlock(pool.lock);
+
+    // The calling thread helps instead of idling
+    while (runNextJob()) {}
+
+    LWP_MutexLock(pool.lock);
+    while (pool.remaining > 0) {
+        LWP_CondWait(pool.workDone, pool.lock);
+    }
+    pool.count = 0;
+    pool.nextIndex = 0;
+    LWP_MutexUnlock(pool.lock);
+
+    LWP_MutexUnlock(pool.submitLock);
+}
+
+void shutdownWorkerPool() {
+    if (!pool.started) return;
+
+    LWP_MutexLock(pool.lock);
+    pool.quit = true;
+    LWP_CondBroadcast(pool.workReady);
+    LWP_MutexUnlock(pool.lock);
+
+    for (int i = 0; i < WORKER_COUNT; i++) {
+        LWP_JoinThread(pool.threads[i], NULL);
+        free(pool.stacks[i]);
+    }
+
+    LWP_CondDestroy(pool.workReady);
+    LWP_CondDestroy(pool.workDone);
+    LWP_MutexDestroy(pool.submitLock);
+    LWP_MutexDestroy(pool.lock);
+    pool.started = false;
+}
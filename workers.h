@@ -0,0 +1,18 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <gccore.h>
+
+#define WORKER_COUNT       2          // Background threads, the caller also takes jobs
+#define WORKER_STACK_SIZE  (64*1024)
+#define WORKER_PRIORITY    64
+
+// Runs once per index, from any worker thread
+typedef void (*WorkerJobFn)(void* context, int index);
+
+void initWorkerPool();
+// Only spreads work over the pool when called from the thread that started it
+void workerParallelFor(WorkerJobFn job, void* context, int count);
+void shutdownWorkerPool();
+
+#endif